@@ -0,0 +1,169 @@
+/**
+ * @file batch.cpp
+ * @brief Stand-alone tool to decode thousands of raw captures at once.
+ *
+ * batch reads raw captures (the '0'/'1' files raw mode and bitgen write, or
+ * whole directories of them) of one track and decodes them LANES at a time
+ * with the bit-sliced decoder. A clean forwards swipe in the ISO format for
+ * the track passes there with a handful of word operations per character
+ * for the whole group. The rest - backwards swipes, other formats, bad
+ * reads - are stragglers, and go through Track::decode() one at a time like
+ * ss would decode them. The groups are split over all the cores.
+ *
+ * Usage: batch [-j threads] [-t track] file|directory ...
+ *
+ * @author Acidus (acidus@msblabs.org)
+ *
+ * This file is part of Stripe Snoop (http://stripesnoop.sourceforge.net)
+ *
+ * Stripe Snoop is licensed under the GPL. See COPYING for more info
+ *
+ * Copyright (C) 2005 Acidus, Most Significant Bit Labs
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+#include "getopt.h"
+#include "batch.h"
+#include "bitslice.h"
+#include "capturefile.h"
+#include "track.h"
+#include "ssflags.h"
+
+/** commandline options, needed by the Track helpers */
+SSFlags ssFlags;
+
+/**
+ * reads a capture file, or every file in a directory
+ *
+ * @param path file or directory
+ * @param caps captures are added here
+ */
+void loadCaptures(const char *path, batchVec &caps) {
+	nameVec names;
+	listCaptures(path, names);
+	for(int i = 0; i < (int) names.size(); i++) {
+		BatchCapture c;
+		c.bits = readCapture(names[i]);
+		if(c.bits == NULL) {
+			delete [] names[i];
+			continue;
+		}
+		c.name = names[i];
+		c.chars = NULL;
+		c.status = DECODE_NOSS;
+		c.sliced = false;
+		caps.push_back(c);
+	}
+}
+
+/**
+ * decodes one group of up to LANES captures
+ *
+ * @param caps captures
+ * @param group which group
+ * @param track track number they were read from, 1-3
+ */
+void decodeGroup(batchVec &caps, const int &group, const int &track) {
+	const FormatEntry &f = formatEntry(isoFormat(track));
+	const Bitstream * streams[LANES];
+	int start[LANES];
+	int length[LANES];
+	int first = group * LANES;
+	int n = (int) caps.size() - first;
+	if(n > LANES)
+		n = LANES;
+	for(int i = 0; i < n; i++)
+		streams[i] = caps[first + i].bits;
+
+	Wordf ok = sliceDecode(f, streams, n, start, length);
+	for(int i = 0; i < n; i++) {
+		BatchCapture &c = caps[first + i];
+		if(ok & laneBit(i)) {
+			c.chars = new char[length[i] + 1];
+			sliceChars(f, *c.bits, start[i], length[i], c.chars);
+			c.status = DECODE_OK;
+			c.sliced = true;
+			continue;
+		}
+		//a straggler, let Track try everything it knows
+		Track t(*c.bits, track);
+		t.setVerbose(false);
+		t.decode();
+		c.status = t.getStatus();
+		if(c.status == DECODE_OK) {
+			c.chars = new char[strlen(t.getChars()) + 1];
+			strcpy(c.chars, t.getChars());
+		}
+	}
+}
+
+/**
+ * takes groups until there are none left. Each group only touches its own
+ * captures, so the threads share nothing else
+ *
+ * @param caps captures
+ * @param next next group to take
+ * @param track track number they were read from
+ */
+void workerThread(batchVec *caps, std::atomic<int> *next, int track) {
+	int numGroups = (caps->size() + LANES - 1) / LANES;
+	int group;
+	while( (group = (*next)++) < numGroups)
+		decodeGroup(*caps, group, track);
+}
+
+int main(int argc, char* argv[]) {
+	int numThreads = std::thread::hardware_concurrency();
+	int track = 2;
+	int c;
+	while ((c = getopt (argc, argv, "j:t:")) != -1) {
+		switch (c) {
+			case 'j':
+				numThreads = atoi(optarg);
+				break;
+			case 't':
+				track = atoi(optarg);
+				break;
+			default:
+				break;
+		}
+	}
+	if(optind >= argc || track < 1 || track > 3) {
+		printf("Usage: batch [-j threads] [-t track] file|directory ...\n");
+		return 1;
+	}
+	if(numThreads < 1)
+		numThreads = 1;
+
+	batchVec caps;
+	for(int i = optind; i < argc; i++)
+		loadCaptures(argv[i], caps);
+
+	std::atomic<int> next(0);
+	std::vector<std::thread> workers;
+	for(int i = 0; i < numThreads; i++)
+		workers.push_back(std::thread(workerThread, &caps, &next, track));
+	for(int i = 0; i < numThreads; i++)
+		workers[i].join();
+
+	int sliced = 0;
+	int decoded = 0;
+	for(int i = 0; i < (int) caps.size(); i++) {
+		if(caps[i].status == DECODE_OK) {
+			printf("%s: %s\n", caps[i].name, caps[i].chars);
+			decoded++;
+			sliced += caps[i].sliced ? 1 : 0;
+		} else {
+			printf("%s: not decoded, %s\n", caps[i].name,
+			       Track::statusString(caps[i].status));
+		}
+	}
+	printf("%d captures, %d decoded (%d bit-sliced, %d one at a time), "
+	       "%d not decoded\n", (int) caps.size(), decoded, sliced,
+	       decoded - sliced, (int) caps.size() - decoded);
+	return 0;
+}
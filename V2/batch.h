@@ -0,0 +1,29 @@
+/*
+ * batch - decodes large numbers of raw captures of one track
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "bitstream.h"
+#include <vector>
+#include <atomic>
+
+//a capture and how it decoded
+class BatchCapture {
+public:
+	char * name;
+	Bitstream * bits;
+	char * chars;	//decoded characters, NULL if it didn't decode
+	int status;	//DECODE_*
+	bool sliced;	//decoded by the bit-sliced pass
+};
+
+typedef std::vector<BatchCapture> batchVec;
+
+void loadCaptures(const char *, batchVec &);
+void decodeGroup(batchVec &, const int&, const int&);
+void workerThread(batchVec *, std::atomic<int> *, int);
+int main(int argc, char* argv[]);
+
+#endif
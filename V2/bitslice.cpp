@@ -0,0 +1,173 @@
+/**
+ * @file bitslice.cpp
+ * @brief Decodes up to 64 bitstreams at once with bit-sliced word operations.
+ *
+ * After the transpose, word p of a slice holds bit p of every lane, so a
+ * character of bpc bits is bpc words. A start or end sentinel is a match
+ * of those words against the sentinel's bits, parity is their XOR, and the
+ * LRC is the running XOR of the data bit words of every lane still reading.
+ * Lanes drop out of the running mask as they fail or hit the end sentinel,
+ * and the loop stops once none are left. This checks exactly what
+ * scanWith() checks for a forwards read, so a lane that passes here would
+ * have decoded DECODE_OK there too.
+ *
+ * @author Acidus (acidus@msblabs.org)
+ *
+ * This file is part of Stripe Snoop (http://stripesnoop.sourceforge.net)
+ *
+ * Stripe Snoop is licensed under the GPL. See COPYING for more info
+ *
+ * Copyright (C) 2005 Acidus, Most Significant Bit Labs
+ */
+
+#include "bitslice.h"
+#include <string.h>
+
+/**
+ * transposes a 64x64 bit matrix in place. Bit 63 - j of word i ends up as
+ * bit 63 - i of word j
+ */
+void transpose64(Wordf *a) {
+	Wordf m = 0x00000000FFFFFFFFULL;
+	for(int j = 32; j != 0; j >>= 1, m ^= (m << j)) {
+		for(int k = 0; k < 64; k = ((k | j) + 1) & ~j) {
+			//swap the low half of row k's pairs with the high half
+			//of row k + j's
+			Wordf t = (a[k] ^ (a[k | j] >> j)) & m;
+			a[k] ^= t;
+			a[k | j] ^= (t << j);
+		}
+	}
+}
+
+/**
+ * @return slice words that match the bpc bit code word c in each lane
+ */
+static Wordf sliceMatch(const Wordf * planes, const int &bpc, const Wordf &c) {
+	Wordf match = ~((Wordf) 0);
+	for(int j = 0; j < bpc; j++) {
+		//first bit of the code word is its most significant
+		if((c >> (bpc - 1 - j)) & 1)
+			match &= planes[j];
+		else
+			match &= ~planes[j];
+	}
+	return match;
+}
+
+/**
+ * decodes a batch of bitstreams forwards in one format
+ *
+ * @param f format to check them against
+ * @param streams bitstreams, lane i is streams[i]
+ * @param n how many, 1-LANES
+ * @param start set to the first 1 bit of each stream, where its start
+ *	sentinel has to be, or -1 if it has none
+ * @param length set to the characters from the start sentinel through the
+ *	end sentinel of each stream that decoded
+ * @return laneBit(i) is set for each stream that decoded, start sentinel
+ *	first, good parity through the end sentinel and a good LRC
+ */
+Wordf sliceDecode(const FormatEntry &f, const Bitstream * const * streams,
+		  const int &n, int * start, int * length) {
+	const int bpc = f.bits;
+	const int pb = f.parityBits;
+	const int dataBits = bpc - pb;
+	//a table of ODD codes fails code 0 and an EVEN one passes it
+	const bool odd = pb != 0 && !f.table[0].parity;
+	Wordf running = 0;
+	int longest = 0;
+	int i, j;
+
+	for(i = 0; i < n; i++) {
+		start[i] = streams[i]->firstSet(0);
+		length[i] = 0;
+		if(start[i] < 0)
+			continue;
+		running |= laneBit(i);
+		if(streams[i]->getSize() - start[i] > longest)
+			longest = streams[i]->getSize() - start[i];
+	}
+
+	//transpose a block of 64 bits of every lane at a time, lanes that are
+	//done already read as zero
+	int blocks = (longest + WORDBITS - 1) / WORDBITS;
+	Wordf * planes = new Wordf[blocks * WORDBITS + WORDBITS];
+	memset(planes, 0, (blocks * WORDBITS + WORDBITS) * sizeof(Wordf));
+	for(int b = 0; b < blocks; b++) {
+		Wordf * rows = &planes[b * WORDBITS];
+		for(i = 0; i < LANES; i++) {
+			int pos = (i < n && start[i] >= 0) ? start[i] + b * WORDBITS : -1;
+			rows[i] = (pos >= 0 && pos < streams[i]->getSize()) ?
+				streams[i]->getBits(pos, WORDBITS) : 0;
+		}
+		transpose64(rows);
+	}
+
+	Wordf lrc[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };	//data bit planes
+	Wordf ok = 0;
+	Wordf pending = 0;	//lanes whose next character is the LRC
+	int numChars = longest / bpc;
+	int k;
+	for(k = 0; k <= numChars && (running | pending) != 0; k++) {
+		const Wordf * c = &planes[k * bpc];
+		if(pending != 0) {
+			//LRC gets the same parity as any other character
+			Wordf match = ~((Wordf) 0);
+			Wordf x = 0;
+			for(j = 0; j < dataBits; j++) {
+				match &= ~(c[j] ^ lrc[j]);
+				x ^= lrc[j];
+			}
+			if(pb != 0)
+				match &= ~(c[dataBits] ^ (odd ? ~x : x));
+			ok |= pending & match;
+			pending = 0;
+		}
+		if(running == 0 || k == numChars)
+			break;
+
+		if(k == 0)
+			running &= sliceMatch(c, bpc, f.ss);
+		if(pb != 0) {
+			Wordf x = 0;
+			for(j = 0; j < bpc; j++)
+				x ^= c[j];
+			running &= odd ? x : ~x;
+		}
+		//Just XOR the Data Bits of each character, not the parity bit
+		for(j = 0; j < dataBits; j++)
+			lrc[j] ^= c[j] & running;
+		pending = running & sliceMatch(c, bpc, f.es);
+		running &= ~pending;
+		for(i = 0; pending != 0 && i < n; i++) {
+			if(pending & laneBit(i))
+				length[i] = k + 1;
+		}
+	}
+	delete [] planes;
+
+	//a lane that ran off its own end only read the zeros after it
+	for(i = 0; i < n; i++) {
+		if((ok & laneBit(i)) &&
+		   start[i] + (length[i] + 1) * bpc > streams[i]->getSize())
+			ok &= ~laneBit(i);
+	}
+	return ok;
+}
+
+/**
+ * looks up the characters of a lane that decoded
+ *
+ * @param f format it decoded in
+ * @param bits its bitstream
+ * @param start bit its start sentinel begins at
+ * @param length characters, start sentinel through end sentinel
+ * @param out buffer of at least length + 1 chars
+ */
+void sliceChars(const FormatEntry &f, const Bitstream &bits, const int &start,
+		const int &length, char * out) {
+	for(int k = 0; k < length; k++)
+		out[k] = f.table[bits.getBits(start + k * f.bits, f.bits)].ch;
+	out[length] = '\0';
+}
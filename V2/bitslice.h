@@ -0,0 +1,29 @@
+/*
+ * Bit-sliced decoding - checks a whole batch of bitstreams at once
+ *
+ * LANES bitstreams are lined up at their first 1 bit and transposed so that
+ * word p holds bit p of every one of them, a bit per lane. Sentinels,
+ * parity and the LRC of all the lanes then come out of plain AND/XOR on
+ * those words, a character at a time, with no per-stream branching. Only
+ * forwards swipes of one format are checked; whatever doesn't pass is left
+ * for Track::decode() to sort out.
+ */
+
+#ifndef BITSLICE_H
+#define BITSLICE_H
+
+#include "bitstream.h"
+#include "trackformat.h"
+
+#define LANES 64	//bitstreams per batch, one per bit of a Wordf
+
+//the bit of a slice word that belongs to a lane
+#define laneBit(i) (((Wordf) 1) << (LANES - 1 - (i)))
+
+void transpose64(Wordf *);
+Wordf sliceDecode(const FormatEntry &, const Bitstream * const *, const int &,
+		  int *, int *);
+void sliceChars(const FormatEntry &, const Bitstream &, const int &,
+		const int &, char *);
+
+#endif
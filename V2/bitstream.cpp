@@ -1,13 +1,17 @@
 /**
  * @file bitstream.cpp
  * @brief Holds the raw bitstream of a magstripe track.
- * 
+ *
+ * Bits are stored packed, 64 bits per word, so a track costs one bit per
+ * bit and scans can work on whole words. Byte-per-bit arrays and ASCII
+ * '0'/'1' strings can still be imported and exported.
+ *
  * @author Acidus (acidus@msblabs.org)
- * 
+ *
  * This file is part of Stripe Snoop (http://stripesnoop.sourceforge.net)
- * 
+ *
  * Stripe Snoop is licensed under the GPL. See COPYING for more info
- * 
+ *
  * Copyright (C) 2005 Acidus, Most Significant Bit Labs
  */
 
@@ -16,41 +20,279 @@
 #include <stdio.h>
 
 
+/**
+ * constructor for a bitstream of s zero bits, filled in with setBit()
+ * @param s length of the bitstream
+ */
+Bitstream::Bitstream(const int &s) {
+	alloc(s);
+}
+
 /**
  * constructor for readers with Direct IO
- * @param bs pointer to a constant bitstream array
+ * @param bs pointer to a constant bitstream array, one bit per byte
  * @param s length of that bitstream
  */
 Bitstream::Bitstream(const Bytef *bs, const int &s) {
-	bitstream = new Bytef[s];
-	memcpy(bitstream, bs, s);
-	size = s;
+	alloc(s);
+	for(int i = 0; i < s; i++) {
+		if(bs[i] != 0)
+			words[i / WORDBITS] |= (Wordf) 1 << (WORDBITS - 1 - i % WORDBITS);
+	}
 }
+
+/**
+ * constructor for ASCII bitstreams, as written by raw mode and bitgen
+ * @param s string of '0' and '1' characters. Anything else is skipped
+ */
+Bitstream::Bitstream(const char *s) {
+	int len = 0;
+	const char * ptr;
+	for(ptr = s; *ptr; ptr++) {
+		if(*ptr == '0' || *ptr == '1')
+			len++;
+	}
+	alloc(len);
+	int i = 0;
+	for(ptr = s; *ptr; ptr++) {
+		if(*ptr == '1')
+			words[i / WORDBITS] |= (Wordf) 1 << (WORDBITS - 1 - i % WORDBITS);
+		if(*ptr == '0' || *ptr == '1')
+			i++;
+	}
+}
+
+Bitstream::Bitstream(const Bitstream &b) {
+	alloc(b.size);
+	memcpy(words, b.words, numWords * sizeof(Wordf));
+}
+
+Bitstream & Bitstream::operator=(const Bitstream &b) {
+	if(this != &b) {
+		delete [] words;
+		alloc(b.size);
+		memcpy(words, b.words, numWords * sizeof(Wordf));
+	}
+	return *this;
+}
+
 /** Bitstream deconstuctor*/
 Bitstream::~Bitstream() {
-	delete [] bitstream; //avoids memory leaks
+	delete [] words; //avoids memory leaks
+}
+
+/**
+ * allocates zeroed storage for s bits, plus one padding word so getBits()
+ * can always read the word after the one it starts in
+ */
+void Bitstream::alloc(const int &s) {
+	size = (s > 0) ? s : 0;
+	numWords = (size + WORDBITS - 1) / WORDBITS;
+	words = new Wordf[numWords + 1];
+	memset(words, 0, (numWords + 1) * sizeof(Wordf));
+}
+
+void Bitstream::setBit(const int &i, const int &v) {
+	Wordf mask = (Wordf) 1 << (WORDBITS - 1 - i % WORDBITS);
+	if(v)
+		words[i / WORDBITS] |= mask;
+	else
+		words[i / WORDBITS] &= ~mask;
+}
+
+/**
+ * inserts a bit, moving the bits from i on up by one
+ * @param i offset the new bit will have
+ * @param v value of the new bit
+ */
+void Bitstream::insertBit(const int &i, const int &v) {
+	if(size + 1 > numWords * WORDBITS) {
+		//out of room, grow by a word
+		Wordf * grown = new Wordf[numWords + 2];
+		memcpy(grown, words, (numWords + 1) * sizeof(Wordf));
+		grown[numWords + 1] = 0;
+		delete [] words;
+		words = grown;
+		numWords++;
+	}
+	size++;
+	int w = i / WORDBITS;
+	for(int k = numWords - 1; k > w; k--)
+		words[k] = (words[k] >> 1) | (words[k - 1] << (WORDBITS - 1));
+	//bits before i stay put in the word i is in
+	Wordf keep = (i % WORDBITS == 0) ? 0 : ~(Wordf) 0 << (WORDBITS - i % WORDBITS);
+	words[w] = (words[w] & keep) | ((words[w] & ~keep) >> 1);
+	setBit(i, v);
+}
+
+/**
+ * removes a bit, moving the bits after it down by one
+ * @param i offset of the bit to remove
+ */
+void Bitstream::removeBit(const int &i) {
+	int w = i / WORDBITS;
+	Wordf keep = (i % WORDBITS == 0) ? 0 : ~(Wordf) 0 << (WORDBITS - i % WORDBITS);
+	words[w] = (words[w] & keep) | ((words[w] << 1) & ~keep) |
+		   (words[w + 1] >> (WORDBITS - 1));
+	for(int k = w + 1; k < numWords; k++)
+		words[k] = (words[k] << 1) | (words[k + 1] >> (WORDBITS - 1));
+	size--;
+	numWords = (size + WORDBITS - 1) / WORDBITS;
+}
+
+const Wordf * Bitstream::getWords() const {
+	return words;
 }
 
-Bytef * Bitstream::getBits() const {
-	return bitstream;
+int Bitstream::getNumWords() const {
+	return numWords;
 }
 
 int Bitstream::getSize() const {
 	return size;
 }
 
+/**
+ * finds the first 1 bit at or after a position, a word at a time
+ * @param from bit to start searching at
+ * @return offset of the bit, or -1 if there are only zeros left
+ */
+int Bitstream::firstSet(const int &from) const {
+	if(from >= size)
+		return -1;
+	int w = from / WORDBITS;
+	//mask off the bits before from in the first word
+	Wordf v = words[w] & (~(Wordf) 0 >> (from % WORDBITS));
+	while(v == 0) {
+		if(++w >= numWords)
+			return -1;
+		v = words[w];
+	}
+	int k = w * WORDBITS;
+	while( (v & ((Wordf) 1 << (WORDBITS - 1))) == 0) {
+		v <<= 1;
+		k++;
+	}
+	return (k < size) ? k : -1;
+}
+
+/**
+ * finds the last 1 bit at or before a position, a word at a time
+ * @param from bit to start searching backwards from
+ * @return offset of the bit, or -1 if there are only zeros before it
+ */
+int Bitstream::lastSet(const int &from) const {
+	if(from < 0 || size == 0)
+		return -1;
+	int f = (from < size) ? from : size - 1;
+	int w = f / WORDBITS;
+	//mask off the bits after f in the first word
+	Wordf v = words[w] & (~(Wordf) 0 << (WORDBITS - 1 - f % WORDBITS));
+	while(v == 0) {
+		if(--w < 0)
+			return -1;
+		v = words[w];
+	}
+	int k = w * WORDBITS + WORDBITS - 1;
+	while( (v & 1) == 0) {
+		v >>= 1;
+		k--;
+	}
+	return k;
+}
+
+/**
+ * finds every offset a single code word occurs at
+ * @param code pattern to find, first bit most significant
+ * @param len length of the pattern in bits (1-32)
+ * @param hits filled with the offsets, in increasing order
+ */
+void Bitstream::findPattern(const Wordf &code, const int &len,
+			    offsetVec &hits) const {
+	BitPattern p;
+	p.code = code;
+	p.length = len;
+	findPatterns(&p, 1, &hits);
+}
+
+/**
+ * finds every offset of several code words in one pass over the words.
+ *
+ * For each word the stream is shifted by 0..len-1 bits once, and a pattern
+ * matches at every position where all shifted copies agree with its bits,
+ * so 64 candidate offsets are tested with a handful of word operations.
+ *
+ * @param pats patterns to find
+ * @param n number of patterns
+ * @param hits array of n offset lists, filled in increasing order
+ */
+void Bitstream::findPatterns(const BitPattern *pats, const int &n,
+			     offsetVec *hits) const {
+	Wordf shifted[32];
+	int maxLen = 0;
+	int i, j;
+	for(i = 0; i < n; i++) {
+		hits[i].clear();
+		if(pats[i].length > maxLen)
+			maxLen = pats[i].length;
+	}
+	for(int w = 0; w < numWords; w++) {
+		//shifted[j] holds bit (p + j) at position p
+		shifted[0] = words[w];
+		for(j = 1; j < maxLen; j++)
+			shifted[j] = (words[w] << j) | (words[w + 1] >> (WORDBITS - j));
+		for(i = 0; i < n; i++) {
+			int len = pats[i].length;
+			//last offset the pattern fits at, relative to this word
+			int last = size - len - w * WORDBITS;
+			if(last < 0)
+				continue;
+			Wordf m = ~(Wordf) 0;
+			for(j = 0; j < len; j++) {
+				if( (pats[i].code >> (len - 1 - j)) & 1)
+					m &= shifted[j];
+				else
+					m &= ~shifted[j];
+			}
+			if(last < WORDBITS - 1)
+				m &= ~(~(Wordf) 0 >> (last + 1));
+			//pull the matches out, most significant (earliest) first
+			int k = w * WORDBITS;
+			while(m != 0) {
+				while( (m & ((Wordf) 1 << (WORDBITS - 1))) == 0) {
+					m <<= 1;
+					k++;
+				}
+				hits[i].push_back(k);
+				m <<= 1;
+				k++;
+			}
+		}
+	}
+}
 
-void Bitstream::reverse() {
-	Bytef * temp = new Bytef[size];
+/**
+ * exports the bitstream one bit per byte
+ * @param bs array of at least getSize() bytes
+ */
+void Bitstream::toBytes(Bytef *bs) const {
 	for(int i = 0; i < size; i++)
-		temp[i]=bitstream[size - 1 - i];
-	memcpy(bitstream, temp, size);
-	delete [] temp;
+		bs[i] = (Bytef) getBit(i);
+}
+
+/**
+ * exports the bitstream as an ASCII '0'/'1' string. Caller deletes it
+ */
+char * Bitstream::toString() const {
+	char * s = new char[size + 1];
+	for(int i = 0; i < size; i++)
+		s[i] = (char) ('0' + getBit(i));
+	s[size] = '\0';
+	return s;
 }
 
 void Bitstream::print(void) const {
 	for(int i=0; i< size; i++)
-		printf("%c",bitstream[i]+48);
+		printf("%c",getBit(i)+48);
 	printf(" --- size: %d\n",size);
 }
-
@@ -1,25 +1,171 @@
 /*
  * Bitstream Class!
+ *
+ * Bits are packed 64 to a word, first bit of the stream in the most
+ * significant bit of the first word. The byte-per-bit and ASCII '0'/'1'
+ * forms are only used for import and export.
  */
 
 #ifndef BITSTREAM_H
 #define BITSTREAM_H
 
+#include <vector>
+
 typedef unsigned char Bytef;
 
+#ifdef _MSC_VER
+typedef unsigned __int64 Wordf;
+#else
+typedef unsigned long long Wordf;
+#endif
+
+#define WORDBITS 64
+
+typedef std::vector<int>  offsetVec;
+
+//a code word to search for, first bit in the most significant position
+class BitPattern {
+public:
+	Wordf code;
+	int length;	//1-32 bits
+};
+
 class Bitstream {
 public:
-	Bitstream(const Bytef *, const int&);
+	Bitstream(const int&);			//all zero bits
+	Bitstream(const Bytef *, const int&);	//import byte-per-bit
+	Bitstream(const char *);		//import ASCII '0'/'1'
+	Bitstream(const Bitstream &);
+	Bitstream & operator=(const Bitstream &);
 	~Bitstream(void);
-	Bytef * getBits(void) const;
+
+	int getBit(const int&) const;
+	Wordf getBits(const int&, const int&) const;
+	void setBit(const int&, const int&);
+	void insertBit(const int&, const int&);
+	void removeBit(const int&);
+	const Wordf * getWords(void) const;
+	int getNumWords(void) const;
 	int getSize(void) const;
-	void reverse(void);
+	int firstSet(const int&) const;
+	int lastSet(const int&) const;
+	void findPattern(const Wordf&, const int&, offsetVec &) const;
+	void findPatterns(const BitPattern *, const int&, offsetVec *) const;
+
+	void toBytes(Bytef *) const;	//export byte-per-bit
+	char * toString(void) const;	//export ASCII '0'/'1'
 	void print(void) const;
 
 protected:
-	
-	Bytef * bitstream;
+
+	Wordf * words;	//numWords + 1, last word is always zero padding
+	int numWords;
 	int size;
+
+	void alloc(const int&);
 };
 
+/**
+ * returns a single bit (0 or 1). Bits past the end read as 0
+ */
+inline int Bitstream::getBit(const int &i) const {
+	return (int) ((words[i / WORDBITS] >> (WORDBITS - 1 - i % WORDBITS)) & 1);
+}
+
+/**
+ * returns n (1-64) bits starting at bit pos, with the first bit in the
+ * most significant position of the result. Bits past the end read as 0
+ */
+inline Wordf Bitstream::getBits(const int &pos, const int &n) const {
+	int w = pos / WORDBITS;
+	int o = pos % WORDBITS;
+	Wordf v = words[w] << o;
+	if(o + n > WORDBITS)
+		v |= words[w + 1] >> (WORDBITS - o);
+	return v >> (WORDBITS - n);
+}
+
+/**
+ * mirrors the bits of a single word
+ */
+inline Wordf mirrorWord(Wordf v) {
+	v = ((v >> 1) & 0x5555555555555555ULL) | ((v & 0x5555555555555555ULL) << 1);
+	v = ((v >> 2) & 0x3333333333333333ULL) | ((v & 0x3333333333333333ULL) << 2);
+	v = ((v >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((v & 0x0F0F0F0F0F0F0F0FULL) << 4);
+	v = ((v >> 8) & 0x00FF00FF00FF00FFULL) | ((v & 0x00FF00FF00FF00FFULL) << 8);
+	v = ((v >> 16) & 0x0000FFFF0000FFFFULL) | ((v & 0x0000FFFF0000FFFFULL) << 16);
+	return (v >> 32) | (v << 32);
+}
+
+/*
+ * BitView - read only window on a Bitstream, forwards or backwards
+ *
+ * Reading a card swiped the wrong way is just a backwards view of the same
+ * storage, so nothing is allocated or copied, and any number of views can
+ * read one Bitstream at the same time.
+ */
+class BitView {
+public:
+	BitView(const Bitstream &, const bool&);
+	int getBit(const int&) const;
+	Wordf getBits(const int&, const int&) const;
+	int getSize(void) const;
+	int firstSet(const int&) const;
+	int lastSet(const int&) const;
+	bool isReversed(void) const;
+	const Bitstream & getBitstream(void) const;
+
+private:
+	const Bitstream * bits;
+	bool reversed;
+	int size;
+};
+
+inline BitView::BitView(const Bitstream &b, const bool &r) {
+	bits = &b;
+	reversed = r;
+	size = b.getSize();
+}
+
+inline int BitView::getBit(const int &i) const {
+	return reversed ? bits->getBit(size - 1 - i) : bits->getBit(i);
+}
+
+/**
+ * same as Bitstream::getBits(), in the direction of the view. pos + n must
+ * not run past the end of a backwards view
+ */
+inline Wordf BitView::getBits(const int &pos, const int &n) const {
+	if(!reversed)
+		return bits->getBits(pos, n);
+	//read the same bits forwards and mirror them
+	return mirrorWord(bits->getBits(size - pos - n, n)) >> (WORDBITS - n);
+}
+
+inline int BitView::getSize() const {
+	return size;
+}
+
+inline int BitView::firstSet(const int &from) const {
+	if(!reversed)
+		return bits->firstSet(from);
+	int k = bits->lastSet(size - 1 - from);
+	return (k < 0) ? -1 : size - 1 - k;
+}
+
+inline int BitView::lastSet(const int &from) const {
+	if(!reversed)
+		return bits->lastSet(from);
+	int k = bits->firstSet(size - 1 - from);
+	return (k < 0) ? -1 : size - 1 - k;
+}
+
+inline bool BitView::isReversed() const {
+	return reversed;
+}
+
+inline const Bitstream & BitView::getBitstream() const {
+	return *bits;
+}
+
 #endif
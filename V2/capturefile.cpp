@@ -0,0 +1,103 @@
+/**
+ * @file capturefile.cpp
+ * @brief Reads raw mode captures from files and directories.
+ *
+ * A capture is a file of '0'/'1' characters, as written by raw mode or
+ * bitgen. A directory is taken to be full of them, and is listed in name
+ * order so a run over it always goes the same way.
+ *
+ * @author Acidus (acidus@msblabs.org)
+ *
+ * This file is part of Stripe Snoop (http://stripesnoop.sourceforge.net)
+ *
+ * Stripe Snoop is licensed under the GPL. See COPYING for more info
+ *
+ * Copyright (C) 2005 Acidus, Most Significant Bit Labs
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+#ifndef _WIN32
+	#include <dirent.h>
+	#include <sys/stat.h>
+#endif
+
+#include "capturefile.h"
+
+/**
+ * reads one '0'/'1' capture file
+ *
+ * @param name file to read
+ * @return its bits, or NULL if it can't be read or has none. The caller
+ *	deletes it
+ */
+Bitstream * readCapture(const char *name) {
+	FILE * fin = fopen(name, "r");
+	if(fin == NULL) {
+		printf("Can't open %s\n", name);
+		return NULL;
+	}
+	fseek(fin, 0, SEEK_END);
+	long len = ftell(fin);
+	fseek(fin, 0, SEEK_SET);
+	char * text = new char[len + 1];
+	len = fread(text, 1, len, fin);
+	text[len] = '\0';
+	fclose(fin);
+
+	Bitstream * bits = new Bitstream(text);
+	delete [] text;
+	if(bits->getSize() == 0) {
+		printf("No bits in %s\n", name);
+		delete bits;
+		return NULL;
+	}
+	return bits;
+}
+
+static char * copyName(const char *s) {
+	char * t = new char[strlen(s) + 1];
+	strcpy(t, s);
+	return t;
+}
+
+static bool nameBefore(const char *a, const char *b) {
+	return strcmp(a, b) < 0;
+}
+
+/**
+ * lists a capture file, or every file in a directory
+ *
+ * @param path file or directory
+ * @param names file names are added here, the caller deletes them
+ */
+void listCaptures(const char *path, nameVec &names) {
+#ifndef _WIN32
+	struct stat st;
+	if(stat(path, &st) == 0 && S_ISDIR(st.st_mode)) {
+		DIR * dir = opendir(path);
+		if(dir == NULL) {
+			printf("Can't open %s\n", path);
+			return;
+		}
+		nameVec found;
+		struct dirent * ent;
+		while( (ent = readdir(dir)) != NULL) {
+			char * name = new char[strlen(path) + strlen(ent->d_name) + 2];
+			sprintf(name, "%s/%s", path, ent->d_name);
+			if(stat(name, &st) == 0 && S_ISREG(st.st_mode))
+				found.push_back(name);
+			else
+				delete [] name;
+		}
+		closedir(dir);
+		//same order every run
+		std::sort(found.begin(), found.end(), nameBefore);
+		names.insert(names.end(), found.begin(), found.end());
+		return;
+	}
+#endif
+	names.push_back(copyName(path));
+}
@@ -0,0 +1,17 @@
+/*
+ * Reading raw mode captures from disk, for the tools that work on lots of
+ * them at once
+ */
+
+#ifndef CAPTUREFILE_H
+#define CAPTUREFILE_H
+
+#include "bitstream.h"
+#include <vector>
+
+typedef std::vector<char *> nameVec;
+
+Bitstream * readCapture(const char *);
+void listCaptures(const char *, nameVec &);
+
+#endif
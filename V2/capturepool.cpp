@@ -0,0 +1,115 @@
+/**
+ * @file capturepool.cpp
+ * @brief Growable capture buffers, and the pool that reuses them.
+ *
+ * @author Acidus (acidus@msblabs.org)
+ *
+ * This file is part of Stripe Snoop (http://stripesnoop.sourceforge.net)
+ *
+ * Stripe Snoop is licensed under the GPL. See COPYING for more info
+ *
+ * Copyright (C) 2005 Acidus, Most Significant Bit Labs
+ */
+
+#include "capturepool.h"
+#include <string.h>
+
+CaptureBuffer::CaptureBuffer() {
+	size = 0;
+	room = FIRSTROOM;
+	limit = FIRSTROOM;
+	samples = new Bytef[room];
+	margins = new Bytef[room];
+}
+
+CaptureBuffer::~CaptureBuffer() {
+	delete [] samples;
+	delete [] margins;
+}
+
+/**
+ * empties the buffer for the next swipe. What it has grown to is kept
+ *
+ * @param l most samples it may hold
+ */
+void CaptureBuffer::reset(const int &l) {
+	size = 0;
+	limit = l;
+	times.clear();
+}
+
+/**
+ * doubles the room, without going past the limit
+ */
+void CaptureBuffer::grow() {
+	int r = (room * 2 < limit) ? room * 2 : limit;
+	Bytef * s = new Bytef[r];
+	Bytef * m = new Bytef[r];
+	memcpy(s, samples, size);
+	memcpy(m, margins, size);
+	delete [] samples;
+	delete [] margins;
+	samples = s;
+	margins = m;
+	room = r;
+}
+
+const Bytef * CaptureBuffer::getSamples() const {
+	return samples;
+}
+
+const Bytef * CaptureBuffer::getMargins() const {
+	return margins;
+}
+
+int CaptureBuffer::getSize() const {
+	return size;
+}
+
+int CaptureBuffer::getLimit() const {
+	return limit;
+}
+
+EdgeTimes & CaptureBuffer::getTimes() {
+	return times;
+}
+
+const EdgeTimes & CaptureBuffer::getTimes() const {
+	return times;
+}
+
+//-------------------------------------------------------------- CapturePool
+
+CapturePool::~CapturePool() {
+	for(unsigned int i = 0; i < spare.size(); i++)
+		delete spare[i];
+}
+
+/**
+ * hands out an empty buffer, a used one if there is one
+ *
+ * @param limit most samples it may hold
+ * @return the buffer, give it back with release()
+ */
+CaptureBuffer * CapturePool::acquire(const int &limit) {
+	CaptureBuffer * b = NULL;
+	lock.lock();
+	if(!spare.empty()) {
+		b = spare.back();
+		spare.pop_back();
+	}
+	lock.unlock();
+	if(b == NULL)
+		b = new CaptureBuffer();
+	b->reset(limit);
+	return b;
+}
+
+/**
+ * takes a buffer back for the next swipe
+ */
+void CapturePool::release(CaptureBuffer * b) {
+	lock.lock();
+	spare.push_back(b);
+	lock.unlock();
+}
@@ -0,0 +1,84 @@
+/*
+ * CaptureBuffer - one track's samples from a swipe, grown as it needs room
+ * CapturePool - keeps the buffers between swipes
+ *
+ * A buffer starts small and doubles when a swipe runs past it, up to the
+ * limit the reader works out from the track's density. Buffers go back to
+ * the pool when a swipe is done and come out again at whatever size they
+ * grew to, so once the pool is warm capturing doesn't allocate at all.
+ */
+
+#ifndef CAPTUREPOOL_H
+#define CAPTUREPOOL_H
+
+#include "bitstream.h"
+#include "edgetimes.h"
+#include <vector>
+#include <mutex>
+
+#define FIRSTROOM 256	//samples a new buffer has room for
+
+class CaptureBuffer {
+public:
+	CaptureBuffer();
+	~CaptureBuffer();
+	void reset(const int&);
+	bool add(const Bytef&, const Bytef&);
+	bool isFull(void) const;
+	const Bytef * getSamples(void) const;
+	const Bytef * getMargins(void) const;
+	int getSize(void) const;
+	int getLimit(void) const;
+	EdgeTimes & getTimes(void);
+	const EdgeTimes & getTimes(void) const;
+
+private:
+	Bytef * samples;	//port byte at each clock strobe
+	Bytef * margins;	//timing margin of each
+	int size;	//samples held
+	int room;	//samples there is room for before growing
+	int limit;	//samples it will never grow past
+	EdgeTimes times;	//when each sample's edge came, if timing
+
+	void grow(void);
+	CaptureBuffer(const CaptureBuffer &);	//not copyable
+	CaptureBuffer & operator=(const CaptureBuffer &);
+};
+
+/**
+ * stores a sample, growing if there's room to
+ *
+ * @param sample port byte
+ * @param margin its timing margin
+ * @return false if the buffer is at its limit and the sample was dropped
+ */
+inline bool CaptureBuffer::add(const Bytef &sample, const Bytef &margin) {
+	if(size >= limit)
+		return false;
+	if(size == room)
+		grow();
+	samples[size] = sample;
+	margins[size] = margin;
+	size++;
+	return true;
+}
+
+/**
+ * @return true once the buffer holds as many samples as it ever will
+ */
+inline bool CaptureBuffer::isFull() const {
+	return size >= limit;
+}
+
+class CapturePool {
+public:
+	~CapturePool();
+	CaptureBuffer * acquire(const int&);
+	void release(CaptureBuffer *);
+
+private:
+	std::vector<CaptureBuffer *> spare;
+	std::mutex lock;	//the capture thread and read() share the pool
+};
+
+#endif
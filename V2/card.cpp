@@ -15,82 +15,184 @@
  * Copyright (C) 2005 Acidus, Most Significant Bit Labs
  */
 #include "card.h"
+#include <stdio.h>
+#include <utility>
 
 Card::Card() {
-	
+	clear();
+}
+
+/**
+ * forgets every track, ready for the next swipe
+ */
+void Card::clear() {
+	present = 0;
+	known = 0;
+}
+
+/**
+ * @return presence bit of a track number, 0 if it isn't an ISO track
+ */
+int Card::trackBit(const int &t) {
+	return (t >= 1 && t <= MAXTRACKS) ? 1 << (t - 1) : 0;
 }
 
 int Card::hasTrack(const int &t) const {
-	//printf("Do we have track ...%d (Size %d)\n", t, trackPresent.size());	
 	//we if don't know the status of any tracks at all...
-	if(trackPresent.empty()) {
-		//printf("We have no tracks! NO means %d\n",NO);
+	if(known == 0)
 		return NO; //tell them we don't know
-	}
-	for(int i=0; i < (signed int) trackPresent.size(); i++) {
-		if(trackPresent.at(i).trackNum == t) {
-			//we do have knowledge of this track!
-			return trackPresent.at(i).present;
-		}
-	}
+	int b = trackBit(t);
+	if(present & b)
+		return YES;
+	if(known & b)
+		return NO;
 	return UNKNOWN;
 }
 
 void Card::addMissingTrack(const int &i) {
-	//printf("Missing Tracks being added");
 	//do we already have this track?
-	if(hasTrack(i) == YES) {
+	if(present & trackBit(i)) {
 		//printf("ERROR Attempted to add missing track twice!\n");
 	} else {
-		//add it to our "present" list
-		TrackPresent t;
-		t.trackNum= i;
-		t.present=NO;
-		trackPresent.push_back(t);
+		known |= trackBit(i);
 	}
 }
 		
 void Card::addTrack(const Track &theTrack) {
-	//printf("ADDING TRACK?\n");
-	//do we already have this track?
-	if(hasTrack(theTrack.getNumber()) == YES) {
+	addTrack(Track(theTrack));
+}
+
+/**
+ * adds a track the caller is done with, without copying it
+ */
+void Card::addTrack(Track &&theTrack) {
+	int b = trackBit(theTrack.getNumber());
+	if(b == 0) {
+		printf("ERROR Attempted to add track %d!\n", theTrack.getNumber());
+	} else if(present & b) {
+		//do we already have this track?
 		printf("ERROR Attempted to add track twice!\n");
 	} else {
-		//add it to our "present" list
-		TrackPresent t;
-		t.trackNum= theTrack.getNumber();
-		//printf("track num is %d\n", t.trackNum);
-		t.present=YES;
-		trackPresent.push_back(t);
-		//add to vector
-		tracks.push_back(theTrack);
+		present |= b;
+		known |= b;
+		tracks[theTrack.getNumber() - 1] = std::move(theTrack);
 	}
 }
 
-Track Card::getTrack(const int &j) const {
+/**
+ * @return the track, which stays the card's. Tests look at it in place
+ */
+const Track & Card::getTrack(const int &j) const {
 	//do we even have this track?
-	int i;
 	if(hasTrack(j) != YES) {
 		printf("ERROR Attempted get nonexistant track! %d\n", j);
-	} 
-	for(i=0; i < (int) tracks.size(); i++) {
-		if(tracks.at(i).getNumber() == j) {
-			break; //we do have knowledge of this track!
-		}
+		static const Track none;
+		return none;
+	}
+	return tracks[j - 1];
+}
+
+/**
+ * turns single bit error correction on or off for all the tracks
+ */
+void Card::setCorrecting(const bool &c) {
+	for(int i=0; i < MAXTRACKS; i++) {
+		tracks[i].setCorrecting(c);
+	}
+}
+
+/**
+ * turns soft decision repair on or off for all the tracks
+ */
+void Card::setSoft(const bool &s) {
+	for(int i=0; i < MAXTRACKS; i++) {
+		tracks[i].setSoft(s);
+	}
+}
+
+/**
+ * turns the decoding commentary on or off for all the tracks
+ */
+void Card::setVerbose(const bool &v) {
+	for(int i=0; i < MAXTRACKS; i++) {
+		tracks[i].setVerbose(v);
 	}
-	return tracks.at(i);
 }
 
 void Card::decodeTracks() {
 	//decode all the tracks
-	for(int i=0; i < (int) tracks.size(); i++) {
-		tracks.at(i).decode();
+	for(int i=0; i < MAXTRACKS; i++) {
+		if(present & (1 << i))
+			tracks[i].decode();
+	}
+}
+
+/**
+ * @return number of repairs made across all the tracks
+ */
+int Card::getCorrections() const {
+	int n = 0;
+	for(int i=0; i < MAXTRACKS; i++) {
+		if(present & (1 << i))
+			n += tracks[i].getCorrections();
 	}
+	return n;
 }
 
 void Card::printTracks() const {
-	for(int i=0; i < (int) tracks.size(); i++) {
-		printf("Track %d:", tracks.at(i).getNumber());
-		printf("%s:\n", tracks.at(i).getChars());
+	for(int i=0; i < MAXTRACKS; i++) {
+		if(!(present & (1 << i)))
+			continue;
+		printf("Track %d:", tracks[i].getNumber());
+		printf("%s:\n", tracks[i].getChars());
+		if(tracks[i].getCorrectedBit() >= 0)
+			printf("Track %d: corrected bit %d\n",
+			       tracks[i].getNumber(),
+			       tracks[i].getCorrectedBit());
+		if(tracks[i].getSlip() == SLIP_DROPPED)
+			printf("Track %d: put back a dropped bit at bit %d\n",
+			       tracks[i].getNumber(),
+			       tracks[i].getSlipBit());
+		if(tracks[i].getSlip() == SLIP_EXTRA)
+			printf("Track %d: took out an extra bit at bit %d\n",
+			       tracks[i].getNumber(),
+			       tracks[i].getSlipBit());
+		for(int j = 0; j < tracks[i].getNumSoftBits(); j++)
+			printf("Track %d: soft decision flipped bit %d\n",
+			       tracks[i].getNumber(), tracks[i].getSoftBit(j));
+		//how the swipe went, if the edges were timed
+		const EdgeTimes * times = tracks[i].getEdgeTimes();
+		if(times != NULL && times->getTotal() > 0) {
+			double ms = times->getTotal() / 1e6;
+			printf("Track %d: %d bits in %.2f ms, %.0f bits/s, "
+			       "bit period %.1f-%.1f us (%d bytes of timing)\n",
+			       tracks[i].getNumber(), times->getNumEdges(), ms,
+			       (times->getNumEdges() - 1) / (ms / 1000),
+			       times->getShortest() / 1e3,
+			       times->getLongest() / 1e3, times->getNumBytes());
+		}
+		//didn't decode, show what could be read, marking bad parity
+		if(tracks[i].isForced()) {
+			const char * conf = tracks[i].getConfidence();
+			int n = printf("Track %d forced:", tracks[i].getNumber());
+			printf("%s: (%s%s, %s)\n", tracks[i].getForcedChars(),
+			       formatEntry(tracks[i].getForcedFormat()).name,
+			       (tracks[i].isForcedReversed()) ? " backwards" : "",
+			       Track::statusString(tracks[i].getForcedStatus()));
+			if(tracks[i].getForcedStatus() == DECODE_PARITY) {
+				printf("%*s", n, "");
+				for(int j = 0; tracks[i].getForcedChars()[j] != 0; j++)
+					printf("%c", (conf[j] == CONF_GOOD) ? ' ' : '^');
+				printf("\n");
+			}
+		}
+		//more than one record, list them all
+		if(tracks[i].getNumRecords() > 1) {
+			for(int j = 0; j < tracks[i].getNumRecords(); j++) {
+				const TrackRecord &r = tracks[i].getRecord(j);
+				printf("  Record %d at bit %d: %s (%s)\n", j + 1,
+				       r.offset, r.chars, Track::statusString(r.status));
+			}
+		}
 	}
 }
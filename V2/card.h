@@ -7,7 +7,6 @@
 #ifndef CARD_H
 #define CARD_H
 #include "track.h"
-#include <vector>
 
 
 //----------------defines
@@ -16,30 +15,31 @@
 			//know if card contains this track
 #define YES 1		//yes, we can read it and yes, it was there
 #define NO 2		//yes, we can read it and no, it was not there
-class TrackPresent {
-public:
-	int trackNum;
-	int present;
-	
-};
-
-typedef std::vector<Track>  TrackVec;
-
-typedef std::vector<TrackPresent> TrackPresentVec;
 
+#define MAXTRACKS 3	//ISO tracks on a card
 
+//the tracks live in the card, by track number, so a card can be reused
+//for the next swipe without allocating
 class Card {
 public:
 	Card();
+	void clear(void);
 	int hasTrack(const int &) const;
 	void addMissingTrack(const int&);
 	void addTrack(const Track &);
-	Track getTrack(const int&) const;
+	void addTrack(Track &&);
+	const Track & getTrack(const int&) const;
+	void setCorrecting(const bool&);
+	void setSoft(const bool&);
+	void setVerbose(const bool&);
 	void decodeTracks(void);
+	int getCorrections(void) const;
 	void printTracks(void) const;
 private:
-	
-	TrackVec tracks;
-	TrackPresentVec trackPresent;
+	static int trackBit(const int&);
+
+	Track tracks[MAXTRACKS];	//track n is at n - 1
+	int present;	//bit per track we have
+	int known;	//bit per track we know is there or missing
 };
 #endif
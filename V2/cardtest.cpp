@@ -18,11 +18,23 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "cardtest.h"
 #include "card.h"
 #include "testresult.h"
 #include "testfuncs.h"
 
+/*
+ * extractName() trims the name it is given in place, so it gets its own copy
+ * of the field
+ */
+static char * extractFieldName(const char * format, const FieldView &f) {
+	char * n = f.copy();
+	char * name = extractName(format, n);
+	delete [] n;
+	return name;
+}
+
 GenericTest::GenericTest() {
 	requiredTracks.clear();
 }
@@ -61,7 +73,7 @@ TestResult VisaTest::runTest(const Card & theCard) const{
 	
 	//Take care of Track 1
 	if(theCard.hasTrack(1) == YES) {
-		Track track1 = theCard.getTrack(1);
+		const Track & track1 = theCard.getTrack(1);
 		//are we an Alphanumeric character set?
 		if(track1.getCharSet() != ALPHANUMERIC) {
 			return result;
@@ -70,18 +82,18 @@ TestResult VisaTest::runTest(const Card & theCard) const{
 		if(track1.getNumFields() != 3) {
 			return result;
 		}
-		char * f1 = track1.getField(0);
+		FieldView f1 = track1.getField(0);
 		//is first character a B?
-		if(*f1 != 'B') {
+		if(f1[0] != 'B') {
 			return result;
 		}
-		f1++; //move past B
+		f1 = f1.from(1); //move past B
 		//starts with a 4?
-		if(*f1 != '4') {
+		if(f1[0] != '4') {
 			return result;
 		}
 		//is it 16 or 13 characters?
-		if(strlen(f1) != 16 && strlen(f1) != 13) {
+		if(f1.length != 16 && f1.length != 13) {
 	       		return result;
 		}
 		
@@ -90,15 +102,15 @@ TestResult VisaTest::runTest(const Card & theCard) const{
 			return result;
 		}
 		//has 101 constant or 120 Constant
-		char * f3 = track1.getField(2);
-		if(strncmp(&f3[4],"101",3) != 0) {
+		FieldView f3 = track1.getField(2);
+		if(!f3.matches(4, "101")) {
 			return result;
 		}
 		//printf("All good\n");
 		// === PASSED ALL THE TESTS! ===
 		tested = true;
 		result.setCardType("Visa Credit Card");
-		char * tmp = extractName("L/F M", track1.getField(1));
+		char * tmp = extractFieldName("L/F M", track1.getField(1));
 		result.addTag("Issued To", tmp);
 		delete [] tmp;
 		result.addTag("Account Number", formatter("XXXX XXXX XXXX XXXX", f1));
@@ -106,13 +118,9 @@ TestResult VisaTest::runTest(const Card & theCard) const{
 		result.addTag("Expires", tmp);
 		delete [] tmp;
 		//get E-pin
-		tmp = new char [8];
-		memset(tmp,0,8);
-		strncpy(tmp,&f3[27],7);
-		result.addTag("Encrypted PIN",tmp);
-		delete [] tmp;
+		result.addTag("Encrypted PIN", f3.sub(27, 7));
 
-		tmp = bankLookup(VISABANKNAMES,f1,4);
+		tmp = bankLookup(VISABANKNAMES, f1, 4);
 		result.addTag("Issuing Bank", tmp);
 		delete [] tmp;
 		
@@ -126,9 +134,9 @@ TestResult VisaTest::runTest(const Card & theCard) const{
 	//Take care of Track 2
 	if(theCard.hasTrack(2) == YES) {
 	
-		Track track2 = theCard.getTrack(2);
-		char * f1 = track2.getField(0);
-		char * f2 = track2.getField(1);
+		const Track & track2 = theCard.getTrack(2);
+		FieldView f1 = track2.getField(0);
+		FieldView f2 = track2.getField(1);
 		if(!tested) {
 			//are we an Alphanumeric character set?
 			if(track2.getCharSet() != NUMERIC) {
@@ -139,11 +147,11 @@ TestResult VisaTest::runTest(const Card & theCard) const{
 				return result;
 			}
 			//starts with a 4?
-			if(*f1 != '4') {
+			if(f1[0] != '4') {
 				return result;
 			}
 			//is it 16 or 13 characters?
-			if(strlen(f1) !=16 && strlen(f1) != 13) {
+			if(f1.length !=16 && f1.length != 13) {
 		       		return result;
 			}
 			//passes mod10
@@ -151,7 +159,7 @@ TestResult VisaTest::runTest(const Card & theCard) const{
 				return result;
 			}
 			//has 101 constant
-			if(strncmp(&f2[4],"101",3) != 0) {
+			if(!f2.matches(4, "101")) {
 				return result;
 			}
 		} //end !tested
@@ -163,12 +171,8 @@ TestResult VisaTest::runTest(const Card & theCard) const{
 		result.addTag("Expires", tmp);
 		delete [] tmp;
 		//get E-pin
-		tmp = new char [8];
-		memset(tmp,0,8);
-		strncpy(tmp,&f2[27],7);
-		result.addTag("Encrypted PIN",tmp);
-		delete [] tmp;
-		tmp = bankLookup(VISABANKNAMES,f1,4);
+		result.addTag("Encrypted PIN", f2.sub(27, 7));
+		tmp = bankLookup(VISABANKNAMES, f1, 4);
 		result.addTag("Issuing Bank", tmp);
 		delete [] tmp;
 
@@ -197,7 +201,7 @@ TestResult ATMTest::runTest(const Card & theCard) const{
 	
 	//Take care of Track 1
 	if(theCard.hasTrack(1) == YES) {
-		Track track1 = theCard.getTrack(1);
+		const Track & track1 = theCard.getTrack(1);
 		//are we an Alphanumeric character set?
 		if(track1.getCharSet() != ALPHANUMERIC) {
 			return result;
@@ -206,18 +210,18 @@ TestResult ATMTest::runTest(const Card & theCard) const{
 		if(track1.getNumFields() != 3) {
 			return result;
 		}
-		char * f1 = track1.getField(0);
+		FieldView f1 = track1.getField(0);
 		//is first character a B?
-		if(*f1 != 'B') {
+		if(f1[0] != 'B') {
 			return result;
 		}
-		f1++; //move past B
+		f1 = f1.from(1); //move past B
 		//starts with a 5?
-		if(*f1 != '5') {
+		if(f1[0] != '5') {
 			return result;
 		}
 		//is it 16 characters?
-		if(strlen(f1) !=16 ) {
+		if(f1.length !=16 ) {
 	       		return result;
 		}
 		//passes mod10
@@ -225,15 +229,15 @@ TestResult ATMTest::runTest(const Card & theCard) const{
 			return result;
 		}
 		//has 101 constant
-		char * f3 = track1.getField(2);
-		if(strncmp(&f3[4],"101",3) != 0 && strncmp(&f3[4], "120", 3) != 0) {
+		FieldView f3 = track1.getField(2);
+		if(!f3.matches(4, "101") && !f3.matches(4, "120")) {
 			return result;
 		}
 		//printf("All good\n");
 		// === PASSED ALL THE TESTS! ===
 		tested = true;
 		result.setCardType("ATM Card");
-		char * tmp = extractName("L/F M", track1.getField(1));
+		char * tmp = extractFieldName("L/F M", track1.getField(1));
 		result.addTag("Issued To", tmp);
 		delete [] tmp;
 		result.addTag("Account Number", formatter("XXXX XXXX XXXX XXXX", f1));
@@ -257,9 +261,9 @@ TestResult ATMTest::runTest(const Card & theCard) const{
 	//Take care of Track 2
 	if(theCard.hasTrack(2) == YES) {
 	
-		Track track2 = theCard.getTrack(2);
-		char * f1 = track2.getField(0);
-		char * f2 = track2.getField(1);
+		const Track & track2 = theCard.getTrack(2);
+		FieldView f1 = track2.getField(0);
+		FieldView f2 = track2.getField(1);
 		if(!tested) {
 			//are we an Alphanumeric character set?
 			if(track2.getCharSet() != NUMERIC) {
@@ -270,11 +274,11 @@ TestResult ATMTest::runTest(const Card & theCard) const{
 				return result;
 			}
 			//starts with a 4?
-			if(*f1 != '5') {
+			if(f1[0] != '5') {
 				return result;
 			}
 			//is it 16 or 13 characters?
-			if(strlen(f1) !=16) {
+			if(f1.length !=16) {
 		       		return result;
 			}
 			//passes mod10
@@ -282,7 +286,7 @@ TestResult ATMTest::runTest(const Card & theCard) const{
 				return result;
 			}
 			//has 101 or 120 constant
-			if(strncmp(&f2[4],"101",3) != 0 && strncmp(&f2[4], "120", 3) != 0) {
+			if(!f2.matches(4, "101") && !f2.matches(4, "120")) {
 				return result;
 			}
 		} //end !tested
@@ -323,7 +327,7 @@ TestResult BoardPassTest::runTest(const Card & theCard) const {
 	char * t;
 	int i;
 
-	Track track1 = theCard.getTrack(1);
+	const Track & track1 = theCard.getTrack(1);
 	//are we an Alphanumeric character set?
 	if(track1.getCharSet() != ALPHANUMERIC) {
 		return result;
@@ -333,13 +337,13 @@ TestResult BoardPassTest::runTest(const Card & theCard) const {
 		return result;
 	}
 	
-	char * f1 = track1.getField(0);
+	FieldView f1 = track1.getField(0);
 	//is first character a W?
-	if(*f1 != 'W') {
+	if(f1[0] != 'W') {
 		return result;
 	}
 
-	if(strlen(f1) != 40) {
+	if(f1.length != 40) {
 		return result;
 	}
 
@@ -354,7 +358,7 @@ TestResult BoardPassTest::runTest(const Card & theCard) const {
 	tested = true;
 	result.setCardType("Airline Boarding Pass");
 
-	i = svIndexLookup(AIRLINENAMES, &f1[7], 2);
+	i = svIndexLookup(AIRLINENAMES, &f1.chars[7], 2);
 	if(i > 0) {
             result.addTag("Carrier", svExtract(AIRLINENAMES, i, 2, ';'));
 	} else {
@@ -363,22 +367,22 @@ TestResult BoardPassTest::runTest(const Card & theCard) const {
 	
 	t = new char[5];
 	memset(t,0,5);
-	strncpy(t,&f1[10],4);
+	strncpy(t,&f1.chars[10],4);
 	if(t[4] == ' ')
 		t[4] = '\0';
 	result.addTag("Flight Number", t);
         memset(t,0,5);
-	strncpy(t,&f1[21], 3);
+	strncpy(t,&f1.chars[21], 3);
 	result.addTag("Seat", t);	
 	
-	i = svIndexLookup(AIRLINECLASSES, &f1[15], 1);
+	i = svIndexLookup(AIRLINECLASSES, &f1.chars[15], 1);
 	if(i > 0) {
             result.addTag("Class", svExtract(AIRLINECLASSES, i, 2, ','));
 	} else {
             result.addTag("Class", "Unregistered Code");
 	}
 	
-	i = svIndexLookup(AIRPORTNAMES, &f1[1], 3);
+	i = svIndexLookup(AIRPORTNAMES, &f1.chars[1], 3);
 	if(i > 0) {
             result.addTag("Departing Airport", svExtract(AIRPORTNAMES, i, 2, ';'));
 	    result.addTag("Origin", svExtract(AIRPORTNAMES, i, 3, ';'));
@@ -386,7 +390,7 @@ TestResult BoardPassTest::runTest(const Card & theCard) const {
             result.addTag("Departing Airport", "Unregistered Code");
 	}
 	
-	i = svIndexLookup(AIRPORTNAMES, &f1[4], 3);
+	i = svIndexLookup(AIRPORTNAMES, &f1.chars[4], 3);
 	if(i > 0) {
             result.addTag("Destination Airport", svExtract(AIRPORTNAMES, i, 2, ';'));
 	    result.addTag("Destination", svExtract(AIRPORTNAMES, i, 3, ';'));
@@ -409,7 +413,7 @@ TestResult PlaneTicketTest::runTest(const Card & theCard) const {
 	char * t;
 	int i;
 
-	Track track1 = theCard.getTrack(1);
+	const Track & track1 = theCard.getTrack(1);
 	//are we an Alphanumeric character set?
 	if(track1.getCharSet() != ALPHANUMERIC) {
 		return result;
@@ -419,13 +423,13 @@ TestResult PlaneTicketTest::runTest(const Card & theCard) const {
 		return result;
 	}
 	
-	char * f1 = track1.getField(0);
+	FieldView f1 = track1.getField(0);
 	//is first character a W?
-	if(*f1 != 'W') {
+	if(f1[0] != 'W') {
 		return result;
 	}
 
-	if(strlen(f1) != 60) {
+	if(f1.length != 60) {
 		return result;
 	}
 
@@ -439,8 +443,8 @@ TestResult PlaneTicketTest::runTest(const Card & theCard) const {
 	tested = true;
 	result.setCardType("Airline Ticket");
 
-	result.addTag("Passenger", extractName("L/F M", &f1[28]));
-	i = svIndexLookup(AIRLINENAMES, &f1[7], 2);
+	result.addTag("Passenger", extractFieldName("L/F M", f1.from(28)));
+	i = svIndexLookup(AIRLINENAMES, &f1.chars[7], 2);
 	if(i > 0) {
             result.addTag("Carrier", svExtract(AIRLINENAMES, i, 2, ';'));
 	} else {
@@ -449,7 +453,7 @@ TestResult PlaneTicketTest::runTest(const Card & theCard) const {
 	
 	t = new char[5];
 	memset(t,0,5);
-	strncpy(t,&f1[10],4);
+	strncpy(t,&f1.chars[10],4);
 	if(t[0] == ' ') {
 		for(int z =0; z < 3; z++)
 			t[z] = t[z+1];
@@ -457,17 +461,17 @@ TestResult PlaneTicketTest::runTest(const Card & theCard) const {
 	}
 	result.addTag("Flight Number", t);
         memset(t,0,5);
-	strncpy(t,&f1[21], 3);
+	strncpy(t,&f1.chars[21], 3);
 	result.addTag("Seat", t);	
 	
-	i = svIndexLookup(AIRLINECLASSES, &f1[15], 1);
+	i = svIndexLookup(AIRLINECLASSES, &f1.chars[15], 1);
 	if(i > 0) {
             result.addTag("Class", svExtract(AIRLINECLASSES, i, 2, ','));
 	} else {
             result.addTag("Class", "Unregistered Code");
 	}
 	
-	i = svIndexLookup(AIRPORTNAMES, &f1[1], 3);
+	i = svIndexLookup(AIRPORTNAMES, &f1.chars[1], 3);
 	if(i > 0) {
             result.addTag("Departing Airport", svExtract(AIRPORTNAMES, i, 2, ';'));
 	    result.addTag("Origin", svExtract(AIRPORTNAMES, i, 3, ';'));
@@ -475,7 +479,7 @@ TestResult PlaneTicketTest::runTest(const Card & theCard) const {
             result.addTag("Departing Airport", "Unregistered Code");
 	}
 	
-	i = svIndexLookup(AIRPORTNAMES, &f1[4], 3);
+	i = svIndexLookup(AIRPORTNAMES, &f1.chars[4], 3);
 	if(i > 0) {
             result.addTag("Destination Airport", svExtract(AIRPORTNAMES, i, 2, ';'));
 	    result.addTag("Destination", svExtract(AIRPORTNAMES, i, 3, ';'));
@@ -501,14 +505,14 @@ BuzzcardOldTest::BuzzcardOldTest() {
 
 TestResult BuzzcardOldTest::runTest(const Card & theCard) const{
 	TestResult result;
-	char * f1 = NULL;
-        char * f2 = NULL;
-	char * f3 = NULL;
-	char * f4 = NULL;
+	FieldView f1;
+        FieldView f2;
+	FieldView f3;
+	FieldView f4;
 
 	if(theCard.hasTrack(2) == YES) {
 
-		Track track2 = theCard.getTrack(2);
+		const Track & track2 = theCard.getTrack(2);
 	
 		//are we a Numeric character set?
 		if(track2.getCharSet() != NUMERIC) return result;
@@ -521,21 +525,21 @@ TestResult BuzzcardOldTest::runTest(const Card & theCard) const{
 		f4 = track2.getField(3);
 
 		//first field is 1570
-		if(strcmp(f1,"1570") !=0) return result;
+		if(!f1.equals("1570")) return result;
 		//2nd field is 9 characters
 	
-		if(strlen(f2) !=9) return result;
+		if(f2.length !=9) return result;
 		//3rd field ==00 || 02
-		if( strcmp(f3,"00")!=0 && strcmp(f3,"02")!=0 )
+		if( !f3.equals("00") && !f3.equals("02") )
 			return result;
 
 
 		//4th field starts with 60177000
-		if(strncmp(f4,"60177000",8) !=0) return result;
+		if(!f4.startsWith("60177000")) return result;
 
 		//WE ARE GOOD!
 		//which type, old or parking/temp?
-		if(strncmp(f2,"000000000",9)==0 || f2[0] == '8') {
+		if(f2.startsWith("000000000") || f2[0] == '8') {
 			result.setCardType("Georgia Tech Parking or Temporary Card");
 		} else {
 			result.setCardType("Georgia Tech Buzzcard - Pre 2002 version");
@@ -563,15 +567,15 @@ BuzzcardNewTest::BuzzcardNewTest() {
 
 TestResult BuzzcardNewTest::runTest(const Card & theCard) const{
 	TestResult result;
-	char * f1 = NULL;
-        char * f2 = NULL;
-	char * f3 = NULL;
-	char * f4 = NULL;
+	FieldView f1;
+        FieldView f2;
+	FieldView f3;
+	FieldView f4;
 
 	bool tested = false;
 
 	if(theCard.hasTrack(2) == YES) {
-		Track track2 = theCard.getTrack(2);
+		const Track & track2 = theCard.getTrack(2);
 		//are we a Numeric character set?
 		if(track2.getCharSet() != NUMERIC) return result;
 		//Do we have 4 fields?
@@ -583,15 +587,15 @@ TestResult BuzzcardNewTest::runTest(const Card & theCard) const{
 		f4 = track2.getField(3);
 	
 		//first field is 1570
-		if(strcmp(f1,"1570") !=0) return result;
+		if(!f1.equals("1570")) return result;
 		//2nd field is 9 characters
-		if(strlen(f2) !=9) return result;
+		if(f2.length !=9) return result;
 		//first character is a "90"
-		if(strncmp(f2, "90", 2) != 0) return result;
+		if(!f2.startsWith("90")) return result;
 		//3rd field ==00
-		if( strcmp(f3,"00")!=0) return result;
+		if( !f3.equals("00")) return result;
 		//4th field starts with 60177000
-		if(strncmp(f4,"60177000",8) !=0) return result;
+		if(!f4.startsWith("60177000")) return result;
 
 		//WE ARE GOOD!
 		//which type, old or parking/temp?
@@ -607,13 +611,13 @@ TestResult BuzzcardNewTest::runTest(const Card & theCard) const{
 
 	if(theCard.hasTrack(3) == YES) {
 		if(!tested) {
-			Track track3 = theCard.getTrack(3);
+			const Track & track3 = theCard.getTrack(3);
 			if(track3.getCharSet() != NUMERIC) return result;
 			//Do we have 1 field?
 			if(track3.getNumFields() != 1) return result;
-			f1 = track3.getField(1);
+			f1 = track3.getField(0);
 			//field starts with 60177000
-			if(strncmp(f1,"60177000",8) !=0) return result;
+			if(!f1.startsWith("60177000")) return result;
 		}
 		
 		result.setCardType("Georgia Tech Buzzcard - GTID version");
@@ -642,7 +646,7 @@ TestResult MastercardTest::runTest(const Card & theCard) const{
 	
 	//Take care of Track 1
 	if(theCard.hasTrack(1) == YES) {
-		Track track1 = theCard.getTrack(1);
+		const Track & track1 = theCard.getTrack(1);
 		//are we an Alphanumeric character set?
 		if(track1.getCharSet() != ALPHANUMERIC) {
 			return result;
@@ -651,12 +655,12 @@ TestResult MastercardTest::runTest(const Card & theCard) const{
 		if(track1.getNumFields() != 3) {
 			return result;
 		}
-		char * f1 = track1.getField(0);
+		FieldView f1 = track1.getField(0);
 		//is first character a B?
-		if(*f1 != 'B') {
+		if(f1[0] != 'B') {
 			return result;
 		}
-		f1++; //move past B
+		f1 = f1.from(1); //move past B
 
 
 		//starts with a 51, 52, 53, 54, or 55
@@ -670,7 +674,7 @@ TestResult MastercardTest::runTest(const Card & theCard) const{
 
 
 		//is it 16 characters?
-		if(strlen(f1) != 16) {
+		if(f1.length != 16) {
 	       		return result;
 		}
 		
@@ -679,15 +683,15 @@ TestResult MastercardTest::runTest(const Card & theCard) const{
 			return result;
 		}
 		//has 101 constant
-		char * f3 = track1.getField(2);
-		if(strncmp(&f3[4],"101",3) != 0) {
+		FieldView f3 = track1.getField(2);
+		if(!f3.matches(4, "101")) {
 			return result;
 		}
 		//printf("All good\n");
 		// === PASSED ALL THE TESTS! ===
 		tested = true;
 		result.setCardType("Mastercard Credit Card");
-		char * tmp = extractName("L/F M", track1.getField(1));
+		char * tmp = extractFieldName("L/F M", track1.getField(1));
 		result.addTag("Issued To", tmp);
 		delete [] tmp;
 		result.addTag("Account Number", formatter("XXXX XXXX XXXX XXXX", f1));
@@ -695,13 +699,9 @@ TestResult MastercardTest::runTest(const Card & theCard) const{
 		result.addTag("Expires", tmp);
 		delete [] tmp;
 		//get E-pin
-		tmp = new char [8];
-		memset(tmp,0,8);
-		strncpy(tmp,&f3[27],7);
-		result.addTag("Encrypted PIN",tmp);
-		delete [] tmp;
+		result.addTag("Encrypted PIN", f3.sub(27, 7));
 
-		tmp = bankLookup(MASTERCARDBANKNAMES,f1,4);
+		tmp = bankLookup(MASTERCARDBANKNAMES, f1, 4);
 		result.addTag("Issuing Bank", tmp);
 		delete [] tmp;
 		
@@ -717,11 +717,11 @@ NinetyNineXTest::NinetyNineXTest() {
 
 TestResult NinetyNineXTest::runTest(const Card & theCard) const{
 	TestResult result;
-	char * f1 = NULL;
+	FieldView f1;
 
 	if(theCard.hasTrack(2) == YES) {
 
-		Track track2 = theCard.getTrack(2);
+		const Track & track2 = theCard.getTrack(2);
 	
 		//are we a Numeric character set?
 		if(track2.getCharSet() != NUMERIC) return result;
@@ -731,7 +731,7 @@ TestResult NinetyNineXTest::runTest(const Card & theCard) const{
 		f1 = track2.getField(0);
 
 		//first field starts 997
-		if(strncmp(f1,"997",3) !=0) return result;
+		if(!f1.startsWith("997")) return result;
 	
 		//WE ARE GOOD!
 		//which type, old or parking/temp?
@@ -754,12 +754,12 @@ BarnesNobleGCTest::BarnesNobleGCTest() {
 
 TestResult BarnesNobleGCTest::runTest(const Card & theCard) const{
 	TestResult result;
-	char * f1 = NULL;
-	char * f2 = NULL;
+	FieldView f1;
+	FieldView f2;
 
 	if(theCard.hasTrack(1) == YES) {
 
-		Track track1 = theCard.getTrack(1);
+		const Track & track1 = theCard.getTrack(1);
 		//are we a Numeric character set?
 		if(track1.getCharSet() != ALPHANUMERIC) return result;
 	
@@ -768,15 +768,15 @@ TestResult BarnesNobleGCTest::runTest(const Card & theCard) const{
 		f2 = track1.getField(1);
 
 		//1st is 16 characters
-		if(strlen(f1)!=16) return result;
+		if(f1.length!=16) return result;
 		//starts with B
 		if(f1[0] != 'B') return result;
 		//move
-		f1++;
+		f1 = f1.from(1);
 		//passes mod10
 		if(!mod10check(f1)) return result;
 		//has 5045 constant
-		if(strncmp(f1,"5045",4)!=0) return result;
+		if(!f1.startsWith("5045")) return result;
 
 		//WE ARE GOOD!
 		result.setCardType("Barnes and Noble Giftcard");
@@ -797,13 +797,13 @@ KrogerTest::KrogerTest() {
 
 TestResult KrogerTest::runTest(const Card & theCard) const{
 	TestResult result;
-	char * f1 = NULL;
-	char * f2 = NULL;
-	char * f3 = NULL;
+	FieldView f1;
+	FieldView f2;
+	FieldView f3;
 
 	if(theCard.hasTrack(1) == YES) {
 
-		Track track1 = theCard.getTrack(1);
+		const Track & track1 = theCard.getTrack(1);
 		//are we a Numeric character set?
 		if(track1.getCharSet() != ALPHANUMERIC) return result;
 	
@@ -812,14 +812,14 @@ TestResult KrogerTest::runTest(const Card & theCard) const{
 		f2 = track1.getField(1);
 		f3 = track1.getField(2);
 
-		if(strcmp(f2,"CARD/S") !=0) return result;
+		if(!f2.equals("CARD/S")) return result;
 
 		//1st is 15 characters
-		if(strlen(f1)!=15) return result;
+		if(f1.length!=15) return result;
 		//snd is at least 3 characters
-		if(strlen(f3)<3) return result;
+		if(f3.length<3) return result;
 		//has 603 constant
-		if(strncmp(f1,"603",3)!=0) return result;
+		if(!f1.startsWith("603")) return result;
 
 		//WE ARE GOOD!
 		result.setCardType("Kroger Plus Shopping Card");
@@ -838,13 +838,13 @@ GapGCTest::GapGCTest() {
 
 TestResult GapGCTest::runTest(const Card & theCard) const{
 	TestResult result;
-	char * f1 = NULL;
-	char * f2 = NULL;
-	char * f3 = NULL;
+	FieldView f1;
+	FieldView f2;
+	FieldView f3;
 
 	if(theCard.hasTrack(1) == YES) {
 
-		Track track1 = theCard.getTrack(1);
+		const Track & track1 = theCard.getTrack(1);
 		//are we a Numeric character set?
 		if(track1.getCharSet() != ALPHANUMERIC) return result;
 	
@@ -854,15 +854,15 @@ TestResult GapGCTest::runTest(const Card & theCard) const{
 		f3 = track1.getField(2);
 
 		
-		if(*f1!='B') return result;
-		f1++;
+		if(f1[0] != 'B') return result;
+		f1 = f1.from(1);
 		
 		//1st is 16 characters
-		if(strlen(f1)!=16) return result;
+		if(f1.length!=16) return result;
 		//starts with 600
-		if(strncmp(f1,"600",3) != 0) return result;
+		if(!f1.startsWith("600")) return result;
 		if(!mod10check(f1)) return result;
-		if(strncmp(f2,"GAURT",5) != 0) return result;
+		if(!f2.startsWith("GAURT")) return result;
 
 		//WE ARE GOOD!
 		result.setCardType("Gap Clothing Gift Card");
@@ -883,13 +883,13 @@ DeltaSkyMilesTest::DeltaSkyMilesTest() {
 
 TestResult DeltaSkyMilesTest::runTest(const Card & theCard) const{
 	TestResult result;
-	char * f1 = NULL;
-	char * f2 = NULL;
-	char * f3 = NULL;
+	FieldView f1;
+	FieldView f2;
+	FieldView f3;
 
 	if(theCard.hasTrack(1) == YES) {
 
-		Track track1 = theCard.getTrack(1);
+		const Track & track1 = theCard.getTrack(1);
 		//are we a Numeric character set?
 		if(track1.getCharSet() != ALPHANUMERIC) return result;
 	
@@ -898,10 +898,10 @@ TestResult DeltaSkyMilesTest::runTest(const Card & theCard) const{
 		f2 = track1.getField(1);
 		
 		f3 = (theCard.getTrack(2)).getField(1);
-		if(strlen(f3) != 11) return result;
-		f3++;
-		if(*f3 != '2') return result;		
-		if(strncmp(f1, "BDL", 3) != 0) return result;
+		if(f3.length != 11) return result;
+		f3 = f3.from(1);
+		if(f3[0] != '2') return result;		
+		if(!f1.startsWith("BDL")) return result;
 
 		//WE ARE GOOD!
 		result.setCardType("Delta Airlines Sky Miles Card");
@@ -920,33 +920,33 @@ RoyalCaribbeanSuiteTest::RoyalCaribbeanSuiteTest() {
 
 TestResult RoyalCaribbeanSuiteTest::runTest(const Card & theCard) const{
 	TestResult result;
-	char * f1 = NULL;
-	char * f2 = NULL;
-	char * f3 = NULL;
+	FieldView f1;
+	FieldView f2;
+	FieldView f3;
 
 	if(theCard.hasTrack(1) == YES) {
 
-		Track track1 = theCard.getTrack(1);
+		const Track & track1 = theCard.getTrack(1);
 		//are we a Numeric character set?
 		if(track1.getCharSet() != ALPHANUMERIC) return result;
 	
 		if(track1.getNumFields() != 5) return result;
-		Track track2 = theCard.getTrack(2);
+		const Track & track2 = theCard.getTrack(2);
 
 		f1 = track1.getField(0);
-		if(strlen(f1) != 32) return result;
+		if(f1.length != 32) return result;
 		f2 = track2.getField(1);
-		if(strlen(f2) != 0) return result;
+		if(f2.length != 0) return result;
 		
 		//WE ARE GOOD!
 		result.setCardType("Royal Caribbean Cruise Ship Card");
-		char * tmp = extractName("L, F", f1);
+		char * tmp = extractFieldName("L, F", f1);
 		result.addTag("Passenger Name", tmp);
 		f1 = track1.getField(2);
 		result.addTag("Cabin Number", f1);
 		f2 = track2.getField(0);
-		while(*f2 == '0' && *f2 !='\0')
-			f2++;
+		while(f2[0] == '0' && f2[0] != '\0')
+			f2 = f2.from(1);
 		result.addTag("Folio Number", f2);
 		result.setUnknowns("Dining Room, Dining Time, Table Number, Sail Date");
 
@@ -966,13 +966,13 @@ OldNavyGCTest::OldNavyGCTest() {
 
 TestResult OldNavyGCTest::runTest(const Card & theCard) const{
 	TestResult result;
-	char * f1 = NULL;
-	char * f2 = NULL;
-	char * f3 = NULL;
+	FieldView f1;
+	FieldView f2;
+	FieldView f3;
 
 	if(theCard.hasTrack(1) == YES) {
 
-		Track track1 = theCard.getTrack(1);
+		const Track & track1 = theCard.getTrack(1);
 		//are we a Numeric character set?
 		if(track1.getCharSet() != ALPHANUMERIC) return result;
 	
@@ -982,15 +982,15 @@ TestResult OldNavyGCTest::runTest(const Card & theCard) const{
 		f3 = track1.getField(2);
 
 		
-		if(*f1!='B') return result;
-		f1++;
+		if(f1[0] != 'B') return result;
+		f1 = f1.from(1);
 		
 		//1st is 16 characters
-		if(strlen(f1)!=16) return result;
+		if(f1.length!=16) return result;
 		//starts with 600
-		if(strncmp(f1,"600",3) != 0) return result;
+		if(!f1.startsWith("600")) return result;
 		if(!mod10check(f1)) return result;
-		if(strncmp(f2,"ONURT",5) != 0) return result;
+		if(!f2.startsWith("ONURT")) return result;
 
 		//WE ARE GOOD!
 		result.setCardType("Old Navy Clothing Gift Card");
@@ -1015,7 +1015,7 @@ TestResult BestBuyGCTest::runTest(const Card & theCard) const{
 	
 	//Take care of Track 1
 	if(theCard.hasTrack(1) == YES) {
-		Track track1 = theCard.getTrack(1);
+		const Track & track1 = theCard.getTrack(1);
 		//are we an Alphanumeric character set?
 		if(track1.getCharSet() != ALPHANUMERIC) {
 			return result;
@@ -1024,23 +1024,23 @@ TestResult BestBuyGCTest::runTest(const Card & theCard) const{
 		if(track1.getNumFields() != 3) {
 			return result;
 		}
-		char * f1 = track1.getField(1);
-		if(strcmp(f1," /                        ") != 0 ) return result;
+		FieldView f1 = track1.getField(1);
+		if(!f1.equals(" /                        ") ) return result;
 
 		f1 = track1.getField(0);
 		//is first character a B?
-		if(*f1 != 'B') return result;
+		if(f1[0] != 'B') return result;
 
-		char * f2 = theCard.getTrack(2).getField(0);
+		FieldView f2 = theCard.getTrack(2).getField(0);
 		//starts with a 3790
-		if(strncmp(f2, "3790",4) != 0) return result;
+		if(!f2.startsWith("3790")) return result;
 	
-		if(strlen(f2) != 15) return result;
+		if(f2.length != 15) return result;
 
 		//passes mod10
 		if(!mod10check(f2)) return result;
 		f2 = theCard.getTrack(2).getField(1);
-		if(strncmp(f2,"1309101",7) != 0) return result;
+		if(!f2.startsWith("1309101")) return result;
 
 		//printf("All good\n");
 		// === PASSED ALL THE TESTS! ===
@@ -1064,32 +1064,32 @@ ATTPhoneTest::ATTPhoneTest() {
 
 TestResult ATTPhoneTest::runTest(const Card & theCard) const {
 	TestResult result;
-	char * f1 = NULL;
-	char * f2 = NULL;
-	char * f3 = NULL;
+	FieldView f1;
+	FieldView f2;
+	FieldView f3;
 
 	if(theCard.hasTrack(1) == YES) {
 
-		Track track1 = theCard.getTrack(1);
+		const Track & track1 = theCard.getTrack(1);
 		//are we a Numeric character set?
 		if(track1.getCharSet() != ALPHANUMERIC) return result;
 	
 		if(track1.getNumFields() != 4) return result;
 		f1 = track1.getField(0);
-		if(strlen(f1) != 1) return result;
+		if(f1.length != 1) return result;
 
-		if(*f1 != 'B') return result;
+		if(f1[0] != 'B') return result;
 		f1 = track1.getField(1);
-		if(strcmp(f1," /") != 0) return result;
+		if(!f1.equals(" /")) return result;
 
 		f1 = track1.getField(2);
-		if(strlen(f1) != 0) return result;
+		if(f1.length != 0) return result;
 		f1 = track1.getField(3);
 
-		if(*f1!='C') return result;
+		if(f1[0] != 'C') return result;
 		
 		f1 = theCard.getTrack(2).getField(0);
-		f1+=4;
+		f1 = f1.from(4);
 
 		//WE ARE GOOD!
 		result.setCardType("AT&T Corporate Calling Card");
@@ -1122,14 +1122,14 @@ AAMVATest::AAMVATest() {
 TestResult AAMVATest::runTest(const Card & theCard) const {
 
 	TestResult result;
-	Track track1 = theCard.getTrack(1);
-	Track track2 = theCard.getTrack(2);
+	const Track & track1 = theCard.getTrack(1);
+	const Track & track2 = theCard.getTrack(2);
 
-	char *t2f1 = track2.getField(0);
-	char *t2f2 = track2.getField(1);
-	char *t1f2 = track1.getField(1);
-	char *t1f3 = track1.getField(2);
-	char *t1f1 = track1.getField(0);
+	FieldView t2f1 = track2.getField(0);
+	FieldView t2f2 = track2.getField(1);
+	FieldView t1f2 = track1.getField(1);
+	FieldView t1f3 = track1.getField(2);
+	FieldView t1f1 = track1.getField(0);
 
 	char day[3]={0,0,0};
 	char year[5]={0,0,0,0,0};
@@ -1141,21 +1141,21 @@ TestResult AAMVATest::runTest(const Card & theCard) const {
 	//DO THE TEST!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
 
 	//1st is at least 7 characters
-	if(strlen(t2f1) < 7) return result;
+	if(t2f1.length < 7) return result;
 	//2nd is at least 12 characters
-	if(strlen(t2f2) < 12) return result;
+	if(t2f2.length < 12) return result;
 	//starts with "636"
-	if(strncmp(t2f1,"636",3)!=0) return result;
+	if(!t2f1.startsWith("636")) return result;
  	//Expiration has a valid month for expire, or 77 88 99
-	if(!isMonth(&t2f2[2]) && strncmp(&t2f2[2],"77",2)!=0
-		&& strncmp(&t2f2[2],"88",2)!=0
-		&& strncmp(&t2f2[2],"99",2)!=0)
+	if(!isMonth(&t2f2.chars[2]) && !t2f2.matches(2, "77")
+		&& !t2f2.matches(2, "88")
+		&& !t2f2.matches(2, "99"))
 			return result;
 	
 	//WE ARE GOOD!
 	result.setCardType("AAMVA Compliant North American Driver's License");
 
-	i = svIndexLookup(AAMVAREGIONS, t2f1, 6);
+	i = svIndexLookup(AAMVAREGIONS, t2f1.chars, 6);
 	if(i > 0) {
 		result.addTag("Issuing Territory", svExtract(AAMVAREGIONS, i, 2, ','));
 	} else {
@@ -1164,48 +1164,48 @@ TestResult AAMVATest::runTest(const Card & theCard) const {
 
 	//funny month fix I think this causes a bug! California is fucked up
 	/*Get Name*/
-	tmp = extractName("L$F$M", t1f2);
+	tmp = extractFieldName("L$F$M", t1f2);
 	result.addTag("Issued To", tmp);
 	delete [] tmp;
 	result.addTag("Street Address", t1f3);
-	result.addTag("City", &t1f1[2]);
+	result.addTag("City", t1f1.from(2));
 	tmp = new char[2];
 	tmp[0]=t1f1[0];
 	tmp[1]=t1f1[1];
 	result.addTag("State",tmp);
 
-	result.addTag("License Number",&t2f1[6]);
+	result.addTag("License Number", t2f1.from(6));
 	//get the DOB
 	memset(tmp2,0,80);
-	if(!isMonth(&t2f2[8])) {
+	if(!isMonth(&t2f2.chars[8])) {
 		//fake month
-		strncpy(tmp2,&t2f2[2],2);
+		strncpy(tmp2,&t2f2.chars[2],2);
 	} else { 
-		strncpy(tmp2,&t2f2[8],2); //grab month
+		strncpy(tmp2,&t2f2.chars[8],2); //grab month
 	}
-	strncpy(day,&t2f2[10],2);
-	strncpy(year,&t2f2[4],4);
+	strncpy(day,&t2f2.chars[10],2);
+	strncpy(year,&t2f2.chars[4],4);
 	i = atoi(tmp2);
 	sprintf(tmp2,"%s %s, %s",monthName(i),day,year);
 	result.addTag("Date of Birth",tmp2);
 
 	//Get the expiration Date
 	memset(year,0,5);
-	strncpy(year,t2f2,2);;
+	strncpy(year,t2f2.chars,2);;
 	j=atoi(year);
 	j = expandYear(j);
 
-	if(!isMonth(&t2f2[8])) {
-		if(strncmp(&t2f2[2],"77",2)==0) {
+	if(!isMonth(&t2f2.chars[8])) {
+		if(t2f2.matches(2, "77")) {
 			strcpy(tmp2,"Never");
-		} else if(strncmp(&t2f2[2],"88",2)==0) {
+		} else if(t2f2.matches(2, "88")) {
 			sprintf(tmp2,"%s %d, %d",monthName(i),lastDotm(i,j),j);
-		} else if(strncmp(&t2f2[2],"99",2)==0) {
+		} else if(t2f2.matches(2, "99")) {
 			sprintf(tmp2,"%s %s, %d",monthName(i),day,j);
 		}
 	} else {
 		//plain expiration date
-		strncpy(tmp2,&t2f2[2],2); //grab month
+		strncpy(tmp2,&t2f2.chars[2],2); //grab month
 		sprintf(tmp2,"%s %d",monthName(atoi(tmp2)),j);
 	}
 		/*
@@ -0,0 +1,47 @@
+/**
+ * @file charset.cpp
+ * @brief Lookup tables for the magstripe character sets.
+ *
+ * The tables are plain constant data, so decoding a character is a single
+ * lookup of its raw code word, which also tells us if its parity is good.
+ * Data bits are recorded least significant bit first, so the index is the
+ * character value with its bits mirrored, followed by the parity bit.
+ *
+ * @author Acidus (acidus@msblabs.org)
+ *
+ * This file is part of Stripe Snoop (http://stripesnoop.sourceforge.net)
+ *
+ * Stripe Snoop is licensed under the GPL. See COPYING for more info
+ *
+ * Copyright (C) 2005 Acidus, Most Significant Bit Labs
+ */
+
+#include "charset.h"
+
+/** BCD "084<2:6>195=3;7?" by raw 5 bit code word */
+const CharCode BCDTable[32] = {
+	{'0',0}, {'0',1}, {'8',1}, {'8',0}, {'4',1}, {'4',0}, {'<',0}, {'<',1},
+	{'2',1}, {'2',0}, {':',0}, {':',1}, {'6',0}, {'6',1}, {'>',1}, {'>',0},
+	{'1',1}, {'1',0}, {'9',0}, {'9',1}, {'5',0}, {'5',1}, {'=',1}, {'=',0},
+	{'3',0}, {'3',1}, {';',1}, {';',0}, {'7',1}, {'7',0}, {'?',0}, {'?',1},
+};
+
+/** Alpha " !\"#$%&'()*+,-./0-9:;<=>?@A-Z[\\]^_" by raw 7 bit code word */
+const CharCode AlphaTable[128] = {
+	{' ',0}, {' ',1}, {'@',1}, {'@',0}, {'0',1}, {'0',0}, {'P',0}, {'P',1},
+	{'(',1}, {'(',0}, {'H',0}, {'H',1}, {'8',0}, {'8',1}, {'X',1}, {'X',0},
+	{'$',1}, {'$',0}, {'D',0}, {'D',1}, {'4',0}, {'4',1}, {'T',1}, {'T',0},
+	{',',0}, {',',1}, {'L',1}, {'L',0}, {'<',1}, {'<',0}, {'\\',0}, {'\\',1},
+	{'"',1}, {'"',0}, {'B',0}, {'B',1}, {'2',0}, {'2',1}, {'R',1}, {'R',0},
+	{'*',0}, {'*',1}, {'J',1}, {'J',0}, {':',1}, {':',0}, {'Z',0}, {'Z',1},
+	{'&',0}, {'&',1}, {'F',1}, {'F',0}, {'6',1}, {'6',0}, {'V',0}, {'V',1},
+	{'.',1}, {'.',0}, {'N',0}, {'N',1}, {'>',0}, {'>',1}, {'^',1}, {'^',0},
+	{'!',1}, {'!',0}, {'A',0}, {'A',1}, {'1',0}, {'1',1}, {'Q',1}, {'Q',0},
+	{')',0}, {')',1}, {'I',1}, {'I',0}, {'9',1}, {'9',0}, {'Y',0}, {'Y',1},
+	{'%',0}, {'%',1}, {'E',1}, {'E',0}, {'5',1}, {'5',0}, {'U',0}, {'U',1},
+	{'-',1}, {'-',0}, {'M',0}, {'M',1}, {'=',0}, {'=',1}, {']',1}, {']',0},
+	{'#',0}, {'#',1}, {'C',1}, {'C',0}, {'3',1}, {'3',0}, {'S',0}, {'S',1},
+	{'+',1}, {'+',0}, {'K',0}, {'K',1}, {';',0}, {';',1}, {'[',1}, {'[',0},
+	{'\'',1}, {'\'',0}, {'G',0}, {'G',1}, {'7',0}, {'7',1}, {'W',1}, {'W',0},
+	{'/',0}, {'/',1}, {'O',1}, {'O',0}, {'?',1}, {'?',0}, {'_',0}, {'_',1},
+};
@@ -0,0 +1,27 @@
+/*
+ * Character set lookup tables
+ *
+ * Each table is indexed by a raw code word exactly as it comes off the
+ * stripe (first bit read in the most significant position, parity bit
+ * last) and gives back the character and whether the code word has the
+ * odd parity every ISO character needs.
+ */
+
+#ifndef CHARSET_H
+#define CHARSET_H
+
+class CharCode {
+public:
+	char ch;	//decoded character
+	bool parity;	//true if the code word passes odd parity
+};
+
+//5 bit BCD (4 data bits + parity), Track 2 and 3
+#define BCDBITS 5
+extern const CharCode BCDTable[32];
+
+//7 bit Alpha (6 data bits + parity), Track 1
+#define ALPHABITS 7
+extern const CharCode AlphaTable[128];
+
+#endif
@@ -0,0 +1,324 @@
+/**
+ * @file discover.cpp
+ * @brief Stand-alone tool to guess the encoding of unknown stripes.
+ *
+ * discover reads raw captures (the '0'/'1' files raw mode and bitgen write,
+ * or a whole directory of them) and tries every way they could have been
+ * encoded: 4 to 8 bits per character, odd, even or no parity, either bit
+ * order, either polarity, every starting offset and both swipe directions.
+ * Each guess is ranked by how many characters pass parity, whether the last
+ * character is a good LRC, whether the first character and the one before
+ * the LRC look like sentinels, and how far the characters are from random.
+ * The work is split over all the cores.
+ *
+ * Usage: discover [-j threads] [-n shown] file|directory ...
+ *
+ * Parity and the LRC don't depend on the bit order, and a backwards swipe
+ * read forwards can pass them too, so those guesses tie. A guess that
+ * lines up with the ISO sentinels wins the tie; otherwise the one that
+ * gives sensible characters is the right one.
+ *
+ * @author Acidus (acidus@msblabs.org)
+ *
+ * This file is part of Stripe Snoop (http://stripesnoop.sourceforge.net)
+ *
+ * Stripe Snoop is licensed under the GPL. See COPYING for more info
+ *
+ * Copyright (C) 2005 Acidus, Most Significant Bit Labs
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <thread>
+
+#include "getopt.h"
+#include "discover.h"
+#include "capturefile.h"
+#include "trackformat.h"
+
+/**
+ * reads a capture file, or every file in a directory
+ *
+ * @param path file or directory
+ * @param caps captures are added here
+ */
+void loadCaptures(const char *path, captureVec &caps) {
+	nameVec names;
+	listCaptures(path, names);
+	for(int i = 0; i < (int) names.size(); i++) {
+		Capture c;
+		c.bits = readCapture(names[i]);
+		if(c.bits == NULL) {
+			delete [] names[i];
+			continue;
+		}
+		c.name = names[i];
+		caps.push_back(c);
+	}
+}
+
+/**
+ * tries every guess with a given number of bits per character
+ *
+ * @param b the capture
+ * @param bpc bits per character, including parity
+ * @param out guesses are added here
+ */
+void tryBits(const Bitstream &b, const int &bpc, hypothesisVec &out) {
+	//the inverted capture, idle is 1 and data starts at the first 0
+	Bitstream inv(b.getSize());
+	for(int i = 0; i < b.getSize(); i++)
+		inv.setBit(i, !b.getBit(i));
+
+	for(int pol = 0; pol < 2; pol++) {
+		for(int dir = 0; dir < 2; dir++) {
+			for(int off = 0; off < bpc; off++)
+				tryFraming((pol == 0) ? b : inv, bpc, pol == 1, off,
+					   dir == 1, out);
+		}
+	}
+}
+
+/**
+ * cuts a capture into characters one way, then scores every parity and
+ * bit order for those characters
+ *
+ * @param b the capture, already inverted if need be
+ * @param bpc bits per character, including parity
+ * @param inverted b was inverted
+ * @param offset the first character starts this many bits before the
+ *	first 1 bit
+ * @param reversed read it backwards
+ * @param out guesses are added here
+ */
+void tryFraming(const Bitstream &b, const int &bpc, const bool &inverted,
+		const int &offset, const bool &reversed, hypothesisVec &out) {
+	BitView bits(b, reversed);
+	int size = bits.getSize();
+	int first = bits.firstSet(0);
+	if(first < offset)
+		return;
+	int last = (reversed) ? size - 1 - b.firstSet(0) : b.lastSet(size - 1);
+	int start = first - offset;
+	int n = (last - start) / bpc + 1;
+	if(start + n * bpc > size)
+		n--;
+	//need at least a start, an end and an LRC
+	if(n < 3)
+		return;
+
+	Wordf * codes = new Wordf[n];
+	Wordf * data = new Wordf[n];
+	int i;
+	for(i = 0; i < n; i++)
+		codes[i] = bits.getBits(start + i * bpc, bpc);
+
+	const int parities[3] = { ODD, EVEN, NOPARITY };
+	for(int p = 0; p < 3; p++) {
+		Hypothesis h;
+		int pb = (parities[p] == NOPARITY) ? 0 : 1;
+		h.bits = bpc;
+		h.parity = parities[p];
+		h.inverted = inverted;
+		h.offset = offset;
+		h.reversed = reversed;
+		h.chars = n;
+
+		//parity bit is recorded last, after the data bits
+		Wordf lrc = 0;
+		h.parityOK = 0;
+		for(i = 0; i < n; i++) {
+			int ones = 0;
+			for(Wordf v = codes[i]; v != 0; v >>= 1)
+				ones += (int) (v & 1);
+			if( (parities[p] == ODD && ones % 2 == 1) ||
+			    (parities[p] == EVEN && ones % 2 == 0) )
+				h.parityOK++;
+			data[i] = codes[i] >> pb;
+			if(i < n - 1)
+				lrc ^= data[i];
+		}
+		h.lrcOK = (lrc == data[n - 1]);
+		h.plausibility = plausibility(data, n - 1, bpc - pb);
+		//start and end sentinels only show up at the ends
+		h.sentinels = (data[0] != data[n - 2]);
+		for(i = 1; i < n - 2; i++) {
+			if(data[i] == data[0] || data[i] == data[n - 2])
+				h.sentinels = false;
+		}
+
+		//no parity to check is worth what a coin toss is
+		double parityScore = (pb == 0) ? 0.5 : (double) h.parityOK / n;
+		h.score = 0.4 * parityScore + 0.15 * h.plausibility;
+		if(h.lrcOK && (pb == 0 || h.parityOK == n))
+			h.score += 0.25;
+		if(h.sentinels)
+			h.score += 0.15;
+		for(i = 0; i < n && i < MAXSHOWN; i++)
+			h.shown[i] = (unsigned char) data[i];
+
+		//an ISO layout, even with unknown contents, wins any tie
+		h.order = LSBFIRST;
+		h.iso = (parities[p] == ODD) &&
+			((bpc == ISOTrack1::bits() && codes[0] == ISOTrack1::ss() &&
+			  codes[n - 2] == ISOTrack1::es()) ||
+			 (bpc == ISOTrack2::bits() && codes[0] == ISOTrack2::ss() &&
+			  codes[n - 2] == ISOTrack2::es()));
+		out.push_back(h);
+		if(h.iso)
+			out.back().score += 0.05;
+		h.order = MSBFIRST;
+		h.iso = false;
+		out.push_back(h);
+	}
+	delete [] codes;
+	delete [] data;
+}
+
+/**
+ * how far a run of characters is from random. Real stripes use a few
+ * characters a lot, a misframed capture uses all of them evenly
+ *
+ * @param data character values
+ * @param n how many
+ * @param dataBits bits per value
+ * @return 0 for evenly spread, up to 1 for a single value
+ */
+double plausibility(const Wordf *data, const int &n, const int &dataBits) {
+	int values = 1 << dataBits;
+	int * counts = new int[values];
+	memset(counts, 0, values * sizeof(int));
+	int i;
+	for(i = 0; i < n; i++)
+		counts[data[i]]++;
+	double entropy = 0;
+	for(i = 0; i < values; i++) {
+		if(counts[i] > 0) {
+			double p = (double) counts[i] / n;
+			entropy -= p * log(p) / log(2.0);
+		}
+	}
+	delete [] counts;
+	//the most a run this short could have
+	double most = log((double) ((n < values) ? n : values)) / log(2.0);
+	return (most > 0) ? 1.0 - entropy / most : 0;
+}
+
+static bool betterHypothesis(const Hypothesis &a, const Hypothesis &b) {
+	return a.score > b.score;
+}
+
+/**
+ * takes (capture, bits per character) jobs until there are none left.
+ * Each job fills in its own list, so the threads share nothing else
+ *
+ * @param caps captures
+ * @param next next job to take
+ * @param keep best guesses to keep from each job
+ */
+void workerThread(captureVec *caps, std::atomic<int> *next, int keep) {
+	int numJobs = caps->size() * (MAXBITS - MINBITS + 1);
+	int job;
+	while( (job = (*next)++) < numJobs) {
+		Capture &c = caps->at(job / (MAXBITS - MINBITS + 1));
+		int k = job % (MAXBITS - MINBITS + 1);
+		hypothesisVec &tries = c.tries[k];
+		tryBits(*c.bits, MINBITS + k, tries);
+		//stable, so equal scores stay in the order they were tried
+		std::stable_sort(tries.begin(), tries.end(), betterHypothesis);
+		if((int) tries.size() > keep)
+			tries.erase(tries.begin() + keep, tries.end());
+	}
+}
+
+const char * parityName(const int &p) {
+	switch(p) {
+		case ODD:
+			return "odd";
+		case EVEN:
+			return "even";
+	}
+	return "no";
+}
+
+/**
+ * prints a guess and the characters it reads
+ */
+void printHypothesis(const Hypothesis &h) {
+	int dataBits = h.bits - ((h.parity == NOPARITY) ? 0 : 1);
+	printf("%d bits, %s parity, %s first, %s, offset %d, %s: ",
+	       h.bits, parityName(h.parity),
+	       (h.order == LSBFIRST) ? "LSB" : "MSB",
+	       (h.inverted) ? "inverted" : "normal", h.offset,
+	       (h.reversed) ? "backwards" : "forwards");
+	printf("parity %d/%d, LRC %s, sentinels %s, score %.2f%s\n", h.parityOK,
+	       h.chars, (h.lrcOK) ? "ok" : "bad", (h.sentinels) ? "ok" : "bad",
+	       h.score, (h.iso) ? " (ISO)" : "");
+	printf("\t");
+	for(int i = 0; i < h.chars && i < MAXSHOWN; i++) {
+		Wordf v = h.shown[i];
+		if(h.order == LSBFIRST)
+			v = mirrorWord(v) >> (WORDBITS - dataBits);
+		//the ISO character sets where they fit, otherwise hex
+		if(dataBits == 4)
+			printf("%c", (char) ('0' + v));
+		else if(dataBits == 6)
+			printf("%c", (char) (' ' + v));
+		else
+			printf("%02X ", (unsigned int) v);
+	}
+	printf("\n");
+}
+
+int main(int argc, char* argv[]) {
+	int numThreads = std::thread::hardware_concurrency();
+	int shown = 3;
+	int c;
+	while ((c = getopt (argc, argv, "j:n:")) != -1) {
+		switch (c) {
+			case 'j':
+				numThreads = atoi(optarg);
+				break;
+			case 'n':
+				shown = atoi(optarg);
+				break;
+			default:
+				break;
+		}
+	}
+	if(optind >= argc) {
+		printf("Usage: discover [-j threads] [-n shown] file|directory ...\n");
+		return 1;
+	}
+	if(numThreads < 1)
+		numThreads = 1;
+
+	captureVec caps;
+	for(int i = optind; i < argc; i++)
+		loadCaptures(argv[i], caps);
+
+	std::atomic<int> next(0);
+	std::vector<std::thread> workers;
+	for(int i = 0; i < numThreads; i++)
+		workers.push_back(std::thread(workerThread, &caps, &next, shown));
+	for(int i = 0; i < numThreads; i++)
+		workers[i].join();
+
+	for(int i = 0; i < (int) caps.size(); i++) {
+		hypothesisVec all;
+		for(int k = 0; k <= MAXBITS - MINBITS; k++)
+			all.insert(all.end(), caps[i].tries[k].begin(),
+				   caps[i].tries[k].end());
+		std::stable_sort(all.begin(), all.end(), betterHypothesis);
+		printf("%s: %d bits\n", caps[i].name, caps[i].bits->getSize());
+		for(int k = 0; k < shown && k < (int) all.size(); k++) {
+			printf("%d. ", k + 1);
+			printHypothesis(all[k]);
+		}
+		printf("\n");
+	}
+	return 0;
+}
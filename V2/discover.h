@@ -0,0 +1,58 @@
+/*
+ * discover - guesses the encoding of unknown stripes
+ */
+
+#ifndef DISCOVER_H
+#define DISCOVER_H
+
+#include "bitstream.h"
+#include <vector>
+#include <atomic>
+
+#define MINBITS 4	//bits per character to try, including parity
+#define MAXBITS 8
+#define MAXSHOWN 64	//characters printed for a candidate
+
+//one guess at how a capture was encoded, and how well it fits
+class Hypothesis {
+public:
+	int bits;	//per character, including any parity bit
+	int parity;	//ODD, EVEN or NOPARITY
+	int order;	//LSBFIRST or MSBFIRST
+	bool inverted;	//ones and zeros swapped
+	int offset;	//bits before the first 1 bit the first character starts
+	bool reversed;	//swiped backwards
+
+	int chars;	//characters read, including the LRC
+	int parityOK;	//characters that passed parity
+	bool lrcOK;	//last character is the LRC of the others
+	bool sentinels;	//first and next to last characters appear only there
+	double plausibility;	//0-1, how far from random the characters look
+	bool iso;	//ISO 7811 bits, parity, order and sentinels
+	double score;	//0-1, used to rank
+	unsigned char shown[MAXSHOWN];	//first characters as read, no parity
+};
+
+typedef std::vector<Hypothesis> hypothesisVec;
+
+//a capture and every guess about it
+class Capture {
+public:
+	char * name;
+	Bitstream * bits;
+	hypothesisVec tries[MAXBITS - MINBITS + 1];	//by bits per character
+};
+
+typedef std::vector<Capture> captureVec;
+
+void loadCaptures(const char *, captureVec &);
+void tryBits(const Bitstream &, const int&, hypothesisVec &);
+void tryFraming(const Bitstream &, const int&, const bool&, const int&,
+		const bool&, hypothesisVec &);
+double plausibility(const Wordf *, const int&, const int&);
+void workerThread(captureVec *, std::atomic<int> *, int);
+void printHypothesis(const Hypothesis &);
+const char * parityName(const int&);
+int main(int argc, char* argv[]);
+
+#endif
@@ -0,0 +1,121 @@
+/**
+ * @file edgetimes.cpp
+ * @brief Delta encoded clock edge times, and the clock they are read from.
+ *
+ * @author Acidus (acidus@msblabs.org)
+ *
+ * This file is part of Stripe Snoop (http://stripesnoop.sourceforge.net)
+ *
+ * Stripe Snoop is licensed under the GPL. See COPYING for more info
+ *
+ * Copyright (C) 2005 Acidus, Most Significant Bit Labs
+ */
+
+#include "edgetimes.h"
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <time.h>
+#endif
+
+EdgeTimes::EdgeTimes() {
+	clear();
+}
+
+/**
+ * empties it for the next swipe. The room it grew to is kept
+ */
+void EdgeTimes::clear() {
+	bytes.clear();
+	edges = 0;
+	total = 0;
+	shortest = 0;
+	longest = 0;
+}
+
+/**
+ * adds the next edge
+ *
+ * @param delta nanoseconds since the edge before it, 0 for the first
+ */
+void EdgeTimes::add(const Wordf &delta) {
+	Wordf v = delta;
+	while(v >= 0x80) {
+		bytes.push_back((Bytef) (v | 0x80));
+		v >>= 7;
+	}
+	bytes.push_back((Bytef) v);
+	if(edges > 0) {
+		total += delta;
+		if(edges == 1 || delta < shortest)
+			shortest = delta;
+		if(delta > longest)
+			longest = delta;
+	}
+	edges++;
+}
+
+/**
+ * reads the deltas back in order: start at 0, and pass what it returns to
+ * get the one after
+ *
+ * @param at byte the delta starts at
+ * @param delta set to the delta
+ * @return byte the next delta starts at
+ */
+int EdgeTimes::next(const int &at, Wordf &delta) const {
+	int i = at;
+	int shift = 0;
+	delta = 0;
+	while(i < (int) bytes.size()) {
+		Bytef b = bytes[i++];
+		delta |= ((Wordf) (b & 0x7F)) << shift;
+		shift += 7;
+		if(!(b & 0x80))
+			break;
+	}
+	return i;
+}
+
+int EdgeTimes::getNumEdges() const {
+	return edges;
+}
+
+int EdgeTimes::getNumBytes() const {
+	return (int) bytes.size();
+}
+
+Wordf EdgeTimes::getTotal() const {
+	return total;
+}
+
+Wordf EdgeTimes::getShortest() const {
+	return shortest;
+}
+
+Wordf EdgeTimes::getLongest() const {
+	return longest;
+}
+
+/**
+ * @return nanoseconds on a clock that only ever counts up at a steady rate,
+ * not one NTP can slew
+ */
+Wordf edgeClock() {
+#ifdef _WIN32
+	LARGE_INTEGER c, f;
+	QueryPerformanceCounter(&c);
+	QueryPerformanceFrequency(&f);
+	return (Wordf) (c.QuadPart / f.QuadPart) * 1000000000ULL +
+	       (Wordf) (c.QuadPart % f.QuadPart) * 1000000000ULL / f.QuadPart;
+#else
+	struct timespec ts;
+	#ifdef CLOCK_MONOTONIC_RAW
+	clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+	#else
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	#endif
+	return (Wordf) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
@@ -0,0 +1,41 @@
+/*
+ * EdgeTimes - when each clock edge of a track came, delta encoded
+ *
+ * Kept only when timing is turned on. Each entry is the time since the
+ * edge before it in nanoseconds, stored 7 bits a byte, low bits first, with
+ * the top bit set on every byte but the last. A bit period is tens to
+ * hundreds of microseconds, so most edges take 3 bytes instead of 8. The
+ * first edge has nothing before it and is stored as 0.
+ */
+
+#ifndef EDGETIMES_H
+#define EDGETIMES_H
+
+#include "bitstream.h"
+#include <vector>
+
+typedef std::vector<Bytef> byteVec;
+
+class EdgeTimes {
+public:
+	EdgeTimes();
+	void clear(void);
+	void add(const Wordf&);
+	int next(const int&, Wordf&) const;
+	int getNumEdges(void) const;
+	int getNumBytes(void) const;
+	Wordf getTotal(void) const;
+	Wordf getShortest(void) const;
+	Wordf getLongest(void) const;
+
+private:
+	byteVec bytes;	//the deltas, encoded
+	int edges;
+	Wordf total;	//nanoseconds from the first edge to the last
+	Wordf shortest;	//shortest and longest time between two edges
+	Wordf longest;
+};
+
+Wordf edgeClock(void);
+
+#endif
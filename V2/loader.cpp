@@ -18,6 +18,10 @@
 #include "loader.h"
 #include "sxmlp.h"
 #include "misc.h"
+#include "trackformat.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 SXMLP xml;
 
@@ -48,10 +52,13 @@ Reader * loadDirectReader() {
 	char * nextTag;
 	
 	int port, cp, c1, c2, c3, d1, d2, d3;
+	int density[MAXTRACKS];
+	CustomFormat * charset = NULL;
 	
 	port = cp = 0;
 	c1 = c2 = c3 = 0;
 	d1 = d2 = d3 = 0;
+	density[0] = density[1] = density[2] = 0;
 		
 	
 	while( (nextTag = xml.nextName()) != NULL) {
@@ -72,14 +79,26 @@ Reader * loadDirectReader() {
 			c3 = atoi(xml.nextValue());
 		} else 	if(strcmp(nextTag, "DATA3") == 0) {
 			d3 = atoi(xml.nextValue());
+		} else 	if(strcmp(nextTag, "DENSITY1") == 0) {
+			//bits per inch, if it isn't the ISO density
+			density[0] = atoi(xml.nextValue());
+		} else 	if(strcmp(nextTag, "DENSITY2") == 0) {
+			density[1] = atoi(xml.nextValue());
+		} else 	if(strcmp(nextTag, "DENSITY3") == 0) {
+			density[2] = atoi(xml.nextValue());
+		} else if(strncmp(nextTag, "charset", 7) == 0) {
+			charset = loadCharset(charset, nextTag, xml.nextValue());
 		} else {
 			//burn it, so we stay in sync
 			xml.nextValue();
 		}
 	}
+	addCharset(charset);
 	//printf("Attempting to construct\n");
 	
-	Reader * myReader= new DirectReader(port, cp, c1, d1, c2, d2, c3, d3);
+	DirectReader * myReader= new DirectReader(port, cp, c1, d1, c2, d2, c3, d3);
+	for(int i = 0; i < MAXTRACKS; i++)
+		myReader->setDensity(i + 1, density[i]);
 
 	return myReader;
 }
@@ -118,3 +137,69 @@ Reader * loadSerialReader() {
 
 	return (Reader *) myReader;
 }
+
+/**
+ * registers a custom character set with the decoder, if it is usable
+ * @param c character set, or NULL
+ */
+void addCharset(CustomFormat * c) {
+	if(c == NULL)
+		return;
+	if(c->build()) {
+		addFormat(c);
+	} else {
+		delete c;
+	}
+}
+
+/**
+ * handles one of the tags that define a custom character set:
+ *
+ * <charset>name</charset> starts a new character set
+ * <charset-bits>    bits per character, including parity (2-8)
+ * <charset-order>   lsb or msb, which data bit is recorded first
+ * <charset-parity>  odd, even or none
+ * <charset-map>     characters for data values 0, 1, 2...
+ * <charset-start>   data value of the start sentinel
+ * <charset-end>     data value of the end sentinel
+ * <charset-delims>  characters that separate fields
+ *
+ * @param c character set being defined, or NULL
+ * @param tag name of the tag
+ * @param value value of the tag
+ * @return character set being defined after this tag
+ */
+CustomFormat * loadCharset(CustomFormat * c, char * tag, char * value) {
+	if(strcmp(tag, "charset") == 0) {
+		//a new one, so the last one is done
+		addCharset(c);
+		c = new CustomFormat();
+		c->setName(value);
+		return c;
+	}
+	if(c == NULL) {
+		printf("\"%s\" outside of a <charset>, ignoring\n", tag);
+		return NULL;
+	}
+	if(strcmp(tag, "charset-bits") == 0) {
+		c->setBits(atoi(value));
+	} else if(strcmp(tag, "charset-order") == 0) {
+		c->setOrder( (strcmp(value, "msb") == 0) ? MSBFIRST : LSBFIRST);
+	} else if(strcmp(tag, "charset-parity") == 0) {
+		if(strcmp(value, "even") == 0)
+			c->setParity(EVEN);
+		else if(strcmp(value, "none") == 0)
+			c->setParity(NOPARITY);
+		else
+			c->setParity(ODD);
+	} else if(strcmp(tag, "charset-map") == 0) {
+		c->setMap(value);
+	} else if(strcmp(tag, "charset-start") == 0) {
+		c->setStart(atoi(value));
+	} else if(strcmp(tag, "charset-end") == 0) {
+		c->setEnd(atoi(value));
+	} else if(strcmp(tag, "charset-delims") == 0) {
+		c->setDelims(value);
+	}
+	return c;
+}
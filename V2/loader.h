@@ -7,6 +7,7 @@
  */
 
 #include "reader.h"
+#include "trackformat.h"
 
 Reader * loadConfig(char * fn);
 
@@ -14,5 +15,9 @@ Reader * loadDirectReader();
 
 Reader * loadSerialReader();
 
+void addCharset(CustomFormat *);
+
+CustomFormat * loadCharset(CustomFormat *, char *, char *);
+
 
 #endif
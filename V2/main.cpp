@@ -27,6 +27,7 @@
  *
  * If you use an option to use the gameport based reader
  * under Linux (ie "./ss" or "./ss -r"), you must be root.
+ * An emulated port (-x) needs no reader and no root.
  *
  * Use of a keyboard based reader doesn't require anything
  * special.
@@ -55,12 +56,70 @@
 #include "card.h"
 #include "database.h"
 #include "misc.h"
+#include "portio.h"
 
 //#include "parser.h"
 //#include "database.h"
 
 SSFlags ssFlags;
 
+#define BENCHLIMIT 1000000	//fastest speed tried, percent of the swipe
+
+/**
+ * reads one swipe of the emulated port at a speed
+ *
+ * @return true if no clock strobe was missed
+ */
+bool benchSwipe(Reader * r, EmulatedPort * emu, const int &speed) {
+	emu->setSpeed(speed);
+	emu->restart();
+	Card card;
+	r->read(card);
+	printf("%7d%%  %9d bits/s  %5d of %5d missed  %6.1f us\n", speed,
+	       emu->getRate(), emu->getMissed(), emu->getStrobes(),
+	       emu->getLongestPoll() / 1000.0);
+	return emu->getStrobes() > 0 && emu->getMissed() == 0;
+}
+
+/**
+ * plays the emulated swipe faster and faster, then closes in on the
+ * highest clock rate the capture loop still catches every strobe at
+ */
+void benchmark(Reader * r, EmulatedPort * emu) {
+	int good = 0;	//fastest speed that kept up, and slowest that didn't
+	int bad = 0;
+	int speed = 100;
+	emu->setSwipes(1);
+	//only real time says how fast the loop is
+	emu->setStepped(false);
+	printf("  Speed        Clock rate        Strobes missed  Longest poll\n");
+	while(1) {
+		if(benchSwipe(r, emu, speed))
+			good = speed;
+		else
+			bad = speed;
+		if(bad == 0) {
+			if(speed >= BENCHLIMIT)
+				break;
+			speed *= 2;
+		} else if(good == 0) {
+			if(speed == 1)
+				break;
+			speed /= 2;
+		} else if(bad - good <= good / 50 + 1) {
+			break;
+		} else {
+			speed = (good + bad) / 2;
+		}
+	}
+	if(good == 0) {
+		printf("Missed strobes even at 1%% speed\n");
+		return;
+	}
+	emu->setSpeed(good);
+	printf("Keeps up to %d bits/s (%d%% speed)\n", emu->getRate(), good);
+}
+
 /*----------------------------------------------------------------------MAIN*/
 int main(int argc, char* argv[])
 {
@@ -68,7 +127,7 @@ int main(int argc, char* argv[])
 	int c;
 //=====================================parse the command line
 	
-	while ((c = getopt (argc, argv, "vlc:i:")) != -1) {
+	while ((c = getopt (argc, argv, "vlestrbc:i:x:")) != -1) {
         switch (c) {
             case 'v':
                 ssFlags.VERBOSE = true;
@@ -76,6 +135,25 @@ int main(int argc, char* argv[])
             case 'l':
                 ssFlags.LOOP = true;
                 break;
+            case 'e':
+                ssFlags.CORRECT = true;
+                break;
+            case 's':
+                ssFlags.SOFT = true;
+                break;
+            case 't':
+                ssFlags.TIMING = true;
+                break;
+            case 'r':
+                ssFlags.RAW = true;
+                break;
+            case 'b':
+                ssFlags.BENCHMARK = true;
+                break;
+            case 'x':
+                ssFlags.EMULATED = true;
+                ssFlags.setEmulatedFile(optarg);
+                break;
             case 'c':
                 ssFlags.CONFIG = true;
 		ssFlags.setConfigFile(optarg);
@@ -106,65 +184,98 @@ int main(int argc, char* argv[])
             myReader = loadConfig(ssFlags.config);
 	}
            
+	//play swipes on a port in software, in place of the hardware
+	EmulatedPort * emu = NULL;
+	if(ssFlags.EMULATED) {
+		if( (emu = loadEmulatedPort(ssFlags.emulated)) == NULL)
+			exit(1);
+		setPortIO(emu);
+	}
+
+	myReader->setVerbose(ssFlags.VERBOSE);
 	myReader->initReader();
+	myReader->setTiming(ssFlags.TIMING);
 	if(ssFlags.RAW) {
 		myReader->readRaw();
 		exit(1);
 	}
-	swipedCard = myReader->read();
+	if(ssFlags.BENCHMARK) {
+		if(emu == NULL) {
+			printf("Benchmarking needs an emulated port (-x)\n");
+			exit(1);
+		}
+		benchmark(myReader, emu);
+		return 0;
+	}
+	//loop mode keeps reading, with the capture on a thread of its own
+	//so swipes that come while one is being printed aren't lost
+	if(ssFlags.LOOP)
+		myReader->startCapture();
+	int lost = 0;
+	do {
+		myReader->read(swipedCard);
 	
-	//----------------------- decode
-	swipedCard.decodeTracks();
-	swipedCard.printTracks();
+		//----------------------- decode
+		swipedCard.setCorrecting(ssFlags.CORRECT);
+		swipedCard.setSoft(ssFlags.SOFT);
+		swipedCard.setVerbose(ssFlags.VERBOSE);
+		swipedCard.decodeTracks();
+		swipedCard.printTracks();
+		if(myReader->getOverflows() > lost) {
+			printf("%d swipes lost (%d samples in all)\n",
+			       myReader->getOverflows() - lost, myReader->getDropped());
+			lost = myReader->getOverflows();
+		}
 
-	//----------------------Database
-	/*SSDatabase theDB;
+		//----------------------Database
+		/*SSDatabase theDB;
 
 
-	printf("\n");
-	TestResult result = theDB.runTests(swipedCard);
-	if(result.isValid()) {
-		//found a match
-		char * foo = result.getCardType();
-		if(isvowel(*foo))
-			printf("Found an %s\n\n", foo);
-		else
-			printf("Found a %s\n\n", foo);
-
-		int c=0;
-		for(int i=0; i<result.getNumTags(); i++)
-			if(strlen(result.getNameTag(i))>(unsigned)c)
-					c=strlen(result.getNameTag(i));
-		c = ((int) c+1) / 8;
-		for(int i=0; i<result.getNumTags(); i++) {
-			printf("%s:",result.getNameTag(i));
-			for(int j = (int) (strlen(result.getNameTag(i))+1) /8; j<=c;j++)
-				printf("\t");
-			printf("%s\n",result.getDataTag(i));
-		}
-		if( (c = result.getNumExtraTags()) > 0) {
-			printf("Other tracks on the card contain ");
-			if(c > 1) {
-				for(int i = 0; i < c - 1; i++)
-					printf("%s, ", result.getExtraTag(i));
-				printf("and ");
+		printf("\n");
+		TestResult result = theDB.runTests(swipedCard);
+		if(result.isValid()) {
+			//found a match
+			char * foo = result.getCardType();
+			if(isvowel(*foo))
+				printf("Found an %s\n\n", foo);
+			else
+				printf("Found a %s\n\n", foo);
+
+			int c=0;
+			for(int i=0; i<result.getNumTags(); i++)
+				if(strlen(result.getNameTag(i))>(unsigned)c)
+						c=strlen(result.getNameTag(i));
+			c = ((int) c+1) / 8;
+			for(int i=0; i<result.getNumTags(); i++) {
+				printf("%s:",result.getNameTag(i));
+				for(int j = (int) (strlen(result.getNameTag(i))+1) /8; j<=c;j++)
+					printf("\t");
+				printf("%s\n",result.getDataTag(i));
 			}
-			printf("%s.\n", result.getExtraTag(c-1));
-		}
-		foo = result.getUnknowns();
-		if(foo != NULL) {
-			printf("Data Possibly encoded: %s\n",foo);
-		}
-		foo = result.getNotes();
-		if(foo != NULL) {
-			printf("Notes: %s\n", foo);
-		} 	
+			if( (c = result.getNumExtraTags()) > 0) {
+				printf("Other tracks on the card contain ");
+				if(c > 1) {
+					for(int i = 0; i < c - 1; i++)
+						printf("%s, ", result.getExtraTag(i));
+					printf("and ");
+				}
+				printf("%s.\n", result.getExtraTag(c-1));
+			}
+			foo = result.getUnknowns();
+			if(foo != NULL) {
+				printf("Data Possibly encoded: %s\n",foo);
+			}
+			foo = result.getNotes();
+			if(foo != NULL) {
+				printf("Notes: %s\n", foo);
+			} 	
 
 		
-	} else {
-		printf("No match in database\n");
-	}
-*/
+		} else {
+			printf("No match in database\n");
+		}
+	*/
+	} while(ssFlags.LOOP);
 	return 0;
 	
 }
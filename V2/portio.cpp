@@ -0,0 +1,520 @@
+/**
+ * @file portio.cpp
+ * @brief Reads the game or parallel port, or a software stand-in for one.
+ *
+ * All of the platform specific port access is here. Readers and tools go
+ * through getPortIO(), which is the hardware unless an EmulatedPort has
+ * been set in its place.
+ *
+ * @author Acidus (acidus@msblabs.org)
+ *
+ * This file is part of Stripe Snoop (http://stripesnoop.sourceforge.net)
+ *
+ * Stripe Snoop is licensed under the GPL. See COPYING for more info
+ *
+ * Copyright (C) 2005 Acidus, Most Significant Bit Labs
+ */
+
+#include "portio.h"
+#include "reader.h"
+#include "capturefile.h"
+#include "edgetimes.h"
+#include "sxmlp.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+// necessary I/O for a Windows build
+#ifdef _WIN32
+ /* prototypes for Inp32out32.dll calls */
+ short _stdcall Inp32(short PortAddress);
+ void _stdcall Out32(short PortAddress, short data);
+#endif
+
+// necessary I/O for a Linux build
+#ifdef __linux__
+ #include <sys/io.h>
+ #include <sys/types.h>
+ #include <unistd.h>
+#endif
+
+#define EMUIPS 10	//default swipe speed, inches per second
+
+static HardwarePort hardware;
+static PortIO * current = &hardware;
+
+/**
+ * @return the port readers and tools should use
+ */
+PortIO * getPortIO() {
+	return current;
+}
+
+/**
+ * puts another port in place of the hardware. Set it before a reader is
+ * initialized
+ *
+ * @param p the port, or NULL for the hardware
+ */
+void setPortIO(PortIO * p) {
+	current = (p != NULL) ? p : &hardware;
+}
+
+PortIO::~PortIO() {
+}
+
+/**
+ * what capture times each clock edge by. For a real port that's the clock
+ *
+ * @return nanoseconds from some fixed point
+ */
+Wordf PortIO::now() {
+	return edgeClock();
+}
+
+//------------------------------------------------------------- HardwarePort
+
+bool HardwarePort::open(const int &) {
+	#ifdef __linux__
+	//If binary is set to +s and owner is root then become root
+	//else silently fail
+	//For use of ss as normal user
+	seteuid(0);
+
+	// Notify Linux that we want to have unfettered I/O port access
+	if(iopl(3)==-1) {
+		printf("Must be root to access I/O ports\n");
+		return false;
+	}
+	return true;
+	#elif defined(_WIN32)
+	return true;
+	#else
+	printf("Not compiled with hardware Interface Support!\n");
+	return false;
+	#endif
+}
+
+int HardwarePort::in(const int &p) {
+	#ifdef __linux__
+	return inb(p);
+	#elif defined(_WIN32)
+	return Inp32(p);
+	#else
+	return 0xFF;
+	#endif
+}
+
+void HardwarePort::out(const int &p, const int &v) {
+	#ifdef __linux__
+	outb(v, p);
+	#elif defined(_WIN32)
+	Out32(p, v);
+	#endif
+}
+
+//------------------------------------------------------------- EmulatedPort
+
+EmulatedPort::EmulatedPort() {
+	port = 0;
+	CP = 0;
+	for(int i = 0; i < EMUTRACKS; i++) {
+		clk[i] = data[i] = 0;
+		bits[i] = NULL;
+		rate[i] = 0;
+	}
+	gap = (Wordf) EMUGAP * 1000000;
+	swipes = 1;
+	poll = EMUPOLL;
+	speed = 100;
+	stepped = false;
+	restart();
+}
+
+EmulatedPort::~EmulatedPort() {
+	for(int i = 0; i < EMUTRACKS; i++)
+		delete bits[i];
+}
+
+/**
+ * answers on a port. Nothing is needed to get at it
+ */
+bool EmulatedPort::open(const int &p) {
+	port = p;
+	restart();
+	return true;
+}
+
+/**
+ * reads the port as it is right now, taking as long as a read of a real
+ * port does
+ */
+int EmulatedPort::in(const int &p) {
+	if(p != port)
+		return 0xFF;
+	if(stepped) {
+		steps += (poll > 0) ? poll : 1;
+		return play(steps);
+	}
+	Wordf now = edgeClock();
+	if(begin == 0)
+		begin = now;
+	int v = play(now - begin);
+	while(poll > 0 && edgeClock() - now < poll) {}
+	return v;
+}
+
+/**
+ * stepped, time is what the reads have added up to, so the edge times of
+ * a swipe come out the same every time it's played
+ */
+Wordf EmulatedPort::now() {
+	return stepped ? steps : edgeClock();
+}
+
+/**
+ * nothing is wired to the outputs
+ */
+void EmulatedPort::out(const int &, const int &) {
+}
+
+/**
+ * gives a track something to play
+ *
+ * @param t track number
+ * @param c port bit of its clock line
+ * @param d port bit of its data line
+ * @param fn '0'/'1' file of its bits
+ * @param r bits per second, or 0 for the ISO density at a brisk swipe
+ * @return false if the file can't be read
+ */
+bool EmulatedPort::setTrack(const int &t, const int &c, const int &d,
+			    const char * fn, const int &r) {
+	if(t < 1 || t > EMUTRACKS)
+		return false;
+	Bitstream * b = readCapture(fn);
+	if(b == NULL)
+		return false;
+	delete bits[t - 1];
+	bits[t - 1] = b;
+	clk[t - 1] = c;
+	data[t - 1] = d;
+	if(r > 0)
+		rate[t - 1] = r;
+	else
+		rate[t - 1] = ((t == 2) ? BPI2 : BPI13) * EMUIPS;
+	return true;
+}
+
+void EmulatedPort::setCP(const int &cp) {
+	CP = cp;
+}
+
+/**
+ * plays a recording made with "ports -w" instead of the tracks. Each line
+ * is the nanoseconds since the recording started and the port byte, in
+ * hex, it changed to then
+ *
+ * @return false if there's no recording in the file
+ */
+bool EmulatedPort::loadRecording(const char * fn) {
+	FILE * fin = fopen(fn, "r");
+	if(fin == NULL) {
+		printf("Can't open %s\n", fn);
+		return false;
+	}
+	recTimes.clear();
+	recValues.clear();
+	unsigned long long t;
+	unsigned int v;
+	while(fscanf(fin, "%llu %x", &t, &v) == 2) {
+		//a recording only ever goes forwards
+		if(!recTimes.empty() && t < recTimes.back())
+			break;
+		recTimes.push_back((Wordf) t);
+		recValues.push_back((Bytef) v);
+	}
+	fclose(fin);
+	if(recTimes.empty()) {
+		printf("No recording in %s\n", fn);
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @param ms milliseconds of nothing before each swipe
+ */
+void EmulatedPort::setGap(const int &ms) {
+	if(ms >= 0)
+		gap = (Wordf) ms * 1000000;
+}
+
+/**
+ * @param n swipes to play, 0 to keep playing them
+ */
+void EmulatedPort::setSwipes(const int &n) {
+	if(n >= 0)
+		swipes = n;
+}
+
+/**
+ * @param ns nanoseconds a read of the port takes, about 1000 for a port on
+ *	the ISA bus. 0 reads as fast as it can
+ */
+void EmulatedPort::setPoll(const int &ns) {
+	if(ns >= 0)
+		poll = ns;
+}
+
+/**
+ * @param s percent of the tracks' rates, or of the recording's speed, to
+ *	play at. Takes effect at restart()
+ */
+void EmulatedPort::setSpeed(const int &s) {
+	if(s > 0)
+		speed = s;
+}
+
+/**
+ * @param b true to move time on by the poll time at each read, rather than
+ *	play in real time
+ */
+void EmulatedPort::setStepped(bool b) {
+	stepped = b;
+}
+
+/**
+ * starts over from the first swipe's gap, with the counts at 0. The gap
+ * starts at the next read
+ */
+void EmulatedPort::restart() {
+	begin = 0;
+	steps = 0;
+	swipe = -1;
+	for(int i = 0; i < EMUTRACKS; i++) {
+		started[i] = 0;
+		low[i] = false;
+	}
+	strobes = 0;
+	caught = 0;
+	lastRead = 0;
+	longest = 0;
+	lengthen();
+}
+
+/**
+ * @return bits per second of the fastest track, at the speed set
+ */
+int EmulatedPort::getRate() const {
+	int r = 0;
+	for(int i = 0; i < EMUTRACKS; i++) {
+		if(bits[i] != NULL && rate[i] > r)
+			r = rate[i];
+	}
+	return (int) ((long long) r * speed / 100);
+}
+
+/**
+ * @return clock strobes played since restart(), up to the last read
+ */
+int EmulatedPort::getStrobes() const {
+	return strobes;
+}
+
+/**
+ * @return strobes that no read saw the clock line fall for. They came and
+ *	went between two reads, or came with no read of the line high before
+ *	them
+ */
+int EmulatedPort::getMissed() const {
+	return strobes - caught;
+}
+
+/**
+ * @return most nanoseconds between two reads during a swipe
+ */
+Wordf EmulatedPort::getLongestPoll() const {
+	return longest;
+}
+
+/**
+ * works out how long a swipe lasts at the speed set
+ */
+void EmulatedPort::lengthen() {
+	length = 0;
+	if(!recTimes.empty()) {
+		length = recTimes.back() * 100 / speed + 1;
+		return;
+	}
+	for(int i = 0; i < EMUTRACKS; i++) {
+		if(bits[i] == NULL)
+			continue;
+		Wordf l = (Wordf) ((double) bits[i]->getSize() * 1e9 * 100 /
+				   ((double) rate[i] * speed));
+		if(l > length)
+			length = l;
+	}
+	length += 2 * EMUEDGE;
+}
+
+/**
+ * the port byte at a time
+ *
+ * @param e nanoseconds since the first read
+ */
+int EmulatedPort::play(const Wordf &e) {
+	Wordf cycle = gap + length;
+	int k = (int) (e / cycle);
+	if(swipes > 0 && k >= swipes)
+		k = swipes - 1;
+	if(k != swipe) {
+		endSwipe();
+		swipe = k;
+	}
+	Wordf at = e - (Wordf) k * cycle;
+	Wordf last = lastRead;
+	lastRead = e;
+	if(at < gap)
+		return (recTimes.empty()) ? 0xFF & ~CP : recValues.front();
+	Wordf s = at - gap;
+	//only reads that were both in the swipe
+	if(s < length && last >= e - s && e - last > longest)
+		longest = e - last;
+	if(recTimes.empty())
+		return playTracks(s);
+	if(s >= length)
+		return recValues.back();
+	Wordf r = s * speed / 100;
+	int i = (int) (std::upper_bound(recTimes.begin(), recTimes.end(), r) -
+		       recTimes.begin());
+	return recValues[(i > 0) ? i - 1 : 0];
+}
+
+/**
+ * the port byte a time into a swipe of the tracks, counting the strobes
+ * played and the ones a read caught
+ *
+ * @param s nanoseconds since the swipe started
+ */
+int EmulatedPort::playTracks(const Wordf &s) {
+	int v = (s < length) ? 0xFF : 0xFF & ~CP;
+	if(s < EMUEDGE)
+		return v;
+	for(int i = 0; i < EMUTRACKS; i++) {
+		if(bits[i] == NULL)
+			continue;
+		int size = bits[i]->getSize();
+		//bit cells gone by, the clock is low from 1/4 to 3/4 of each
+		double pos = (double) (s - EMUEDGE) * rate[i] * speed / 100 / 1e9;
+		int n = (pos < 0.25) ? 0 : (int) (pos - 0.25) + 1;
+		if(n > size)
+			n = size;
+		bool l = false;
+		int b = (int) pos;
+		if(b < size) {
+			double f = pos - b;
+			if(bits[i]->getBit(b))
+				v &= ~data[i];
+			if(f >= 0.25 && f < 0.75) {
+				v &= ~clk[i];
+				l = true;
+			}
+		}
+		strobes += n - started[i];
+		started[i] = n;
+		if(l && !low[i])
+			caught++;
+		low[i] = l;
+	}
+	return v;
+}
+
+/**
+ * counts every strobe of the last swipe as played, caught or not, before
+ * the next one starts
+ */
+void EmulatedPort::endSwipe() {
+	for(int i = 0; i < EMUTRACKS; i++) {
+		if(swipe >= 0 && bits[i] != NULL)
+			strobes += bits[i]->getSize() - started[i];
+		started[i] = 0;
+		low[i] = false;
+	}
+}
+
+/**
+ * makes an EmulatedPort from an XML file like config.xml, rooted at
+ * <EmulatedPort>
+ *
+ * @param fn file name
+ * @return the port, or NULL if it can't be loaded
+ */
+EmulatedPort * loadEmulatedPort(char * fn) {
+	SXMLP xml;
+	if(!xml.loadFile(fn) || strcmp(xml.getRootName(), "EmulatedPort") != 0) {
+		printf("Could not open/parse emulated port file \"%s\"\n", fn);
+		return NULL;
+	}
+	EmulatedPort * emu = new EmulatedPort();
+	int c[EMUTRACKS], d[EMUTRACKS], r[EMUTRACKS];
+	char * b[EMUTRACKS];
+	char * rec = NULL;
+	char * nextTag;
+	int i;
+	for(i = 0; i < EMUTRACKS; i++) {
+		c[i] = d[i] = r[i] = 0;
+		b[i] = NULL;
+	}
+
+	while( (nextTag = xml.nextName()) != NULL) {
+		char * v = xml.nextValue();
+		int t = nextTag[strlen(nextTag) - 1] - '1';
+		if(strcmp(nextTag, "CP") == 0) {
+			emu->setCP(atoi(v));
+		} else if(t >= 0 && t < EMUTRACKS &&
+			  strncmp(nextTag, "CLK", 3) == 0) {
+			c[t] = atoi(v);
+		} else if(t >= 0 && t < EMUTRACKS &&
+			  strncmp(nextTag, "DATA", 4) == 0) {
+			d[t] = atoi(v);
+		} else if(t >= 0 && t < EMUTRACKS &&
+			  strncmp(nextTag, "BITS", 4) == 0) {
+			//'0'/'1' file the track plays
+			b[t] = v;
+		} else if(t >= 0 && t < EMUTRACKS &&
+			  strncmp(nextTag, "RATE", 4) == 0) {
+			//bits per second
+			r[t] = atoi(v);
+		} else if(strcmp(nextTag, "recording") == 0) {
+			rec = v;
+		} else if(strcmp(nextTag, "gap") == 0) {
+			emu->setGap(atoi(v));
+		} else if(strcmp(nextTag, "swipes") == 0) {
+			emu->setSwipes(atoi(v));
+		} else if(strcmp(nextTag, "poll") == 0) {
+			emu->setPoll(atoi(v));
+		} else if(strcmp(nextTag, "speed") == 0) {
+			emu->setSpeed(atoi(v));
+		} else if(strcmp(nextTag, "stepped") == 0) {
+			emu->setStepped(strcmp(v, "true") == 0);
+		}
+	}
+	for(i = 0; i < EMUTRACKS; i++) {
+		if(b[i] == NULL)
+			continue;
+		if(c[i] == 0 || d[i] == 0 ||
+		   !emu->setTrack(i + 1, c[i], d[i], b[i], r[i])) {
+			printf("Track %d of \"%s\" can't be played\n", i + 1, fn);
+			delete emu;
+			return NULL;
+		}
+	}
+	if(rec != NULL && !emu->loadRecording(rec)) {
+		delete emu;
+		return NULL;
+	}
+	emu->restart();
+	return emu;
+}
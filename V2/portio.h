@@ -0,0 +1,110 @@
+/*
+ * PortIO - where the game or parallel port a DirectReader polls is read
+ * HardwarePort - the real port, through inb/outb on Linux or Inpout32.dll
+ *                on Windows
+ * EmulatedPort - a port played back in software, so capture can be run and
+ *                timed with no reader and no root
+ *
+ * An EmulatedPort plays swipes of CLK/DATA/CP waveforms on whichever port
+ * bits it is told. Each track is a '0'/'1' file, like raw mode writes,
+ * clocked out at its own rate: the data line is set at the start of a bit
+ * cell and the clock line is low for the middle half of it, so a poller
+ * that looks less often than that misses strobes. A recording made with
+ * "ports -w" can be played instead. Time is real time, and each read of
+ * the port can be made to take as long as one on an ISA bus does. Stepped,
+ * time only moves on by that much at each read instead, so a swipe plays
+ * the same every time however the poller is scheduled.
+ */
+
+#ifndef PORTIO_H
+#define PORTIO_H
+
+#include "bitstream.h"
+#include <vector>
+
+#define EMUTRACKS 3	//tracks an EmulatedPort plays
+#define EMUGAP 100	//default milliseconds before each swipe
+#define EMUPOLL 1000	//default nanoseconds a read of the port takes
+#define EMUEDGE 1000000	//nanoseconds CP leads and trails the bits by
+
+class PortIO {
+public:
+	virtual ~PortIO();
+	virtual bool open(const int&) = 0;	//get at a port, false if we can't
+	virtual int in(const int&) = 0;
+	virtual void out(const int&, const int&) = 0;
+	virtual Wordf now(void);	//nanoseconds, as the port sees time go by
+};
+
+class HardwarePort : public PortIO {
+public:
+	virtual bool open(const int&);
+	virtual int in(const int&);
+	virtual void out(const int&, const int&);
+};
+
+class EmulatedPort : public PortIO {
+public:
+	EmulatedPort();
+	virtual ~EmulatedPort();
+	virtual bool open(const int&);
+	virtual int in(const int&);
+	virtual void out(const int&, const int&);
+	virtual Wordf now(void);
+
+	bool setTrack(const int&, const int&, const int&, const char *, const int&);
+	void setCP(const int&);
+	bool loadRecording(const char *);
+	void setGap(const int&);
+	void setSwipes(const int&);
+	void setPoll(const int&);
+	void setSpeed(const int&);
+	void setStepped(bool);
+	void restart(void);
+
+	int getRate(void) const;
+	int getStrobes(void) const;
+	int getMissed(void) const;
+	Wordf getLongestPoll(void) const;
+
+private:
+	int port;	//port it answers on, others read as all high
+	int CP;	//port bit of the card present line, 0 for none
+	int clk[EMUTRACKS];	//port bits of each track's lines
+	int data[EMUTRACKS];
+	Bitstream * bits[EMUTRACKS];	//what each track plays, NULL if nothing
+	int rate[EMUTRACKS];	//bits per second, at 100% speed
+
+	std::vector<Wordf> recTimes;	//a recording, if there is one: when the
+	std::vector<Bytef> recValues;	//port changed, and what to
+
+	Wordf gap;	//nanoseconds before each swipe
+	int swipes;	//swipes to play, 0 for no end
+	Wordf poll;	//nanoseconds each read takes
+	int speed;	//percent of the rates, or of the recording's speed
+	bool stepped;	//time moves on only by poll at each read
+
+	Wordf begin;	//when the first swipe's gap started, 0 until a read
+	Wordf steps;	//stepped, nanoseconds since then
+	Wordf length;	//nanoseconds a swipe lasts
+	int swipe;	//swipe the counts below are for, -1 before the first
+	int started[EMUTRACKS];	//strobes of it begun, as of the last read
+	bool low[EMUTRACKS];	//clock line low at the last read
+	int strobes;	//strobes played since restart()
+	int caught;	//ones a read saw the clock line fall for
+	Wordf lastRead;
+	Wordf longest;	//longest time between two reads during a swipe
+
+	void lengthen(void);
+	int play(const Wordf&);
+	int playTracks(const Wordf&);
+	void endSwipe(void);
+	EmulatedPort(const EmulatedPort &);	//not copyable
+	EmulatedPort & operator=(const EmulatedPort &);
+};
+
+PortIO * getPortIO(void);
+void setPortIO(PortIO *);
+EmulatedPort * loadEmulatedPort(char *);
+
+#endif
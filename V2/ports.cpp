@@ -22,49 +22,42 @@
 #include <stdlib.h>
 #include <time.h>
 
-// necessary I/O for a Linux build
-#ifdef __linux__
- #include <sys/io.h>
- #include <sys/types.h>
- #include <unistd.h>
- #define Inp32 inb
- #define Out32 outb
-#endif
-
-// necessary I/O for a Windows build
-#ifdef _WIN32
- /* prototypes for Inp32out32.dll calls */
- short _stdcall Inp32(short PortAddress);
- void _stdcall Out32(short PortAddress, short data);
-#endif
+#include "portio.h"
+#include "edgetimes.h"
 
 int main(int argc, char * argv[]) {
 
 	bool usePower = false;
+	FILE * record = NULL;
 	
 	printf("ports - Stripe Snoop interface developer tool\n");
 	printf("(C) 2005 Acidus, Most Significant Bit Labs\n");
 
-	if(argc==2) {
-		if(strcmp(argv[1], "-?") ==0) {
-			printf("ports [--power]\n");
+	for(int a = 1; a < argc; a++) {
+		if(strcmp(argv[a], "--power") ==0) {
+			usePower = true;
+		} else if(strcmp(argv[a], "-x") ==0 && a + 1 < argc) {
+			EmulatedPort * emu = loadEmulatedPort(argv[++a]);
+			if(emu == NULL)
+				exit(1);
+			setPortIO(emu);
+		} else if(strcmp(argv[a], "-w") ==0 && a + 1 < argc) {
+			if( (record = fopen(argv[++a], "w")) == NULL) {
+				printf("Can't write %s\n", argv[a]);
+				exit(1);
+			}
+		} else {
+			printf("ports [--power] [-x emulated.xml] [-w recording]\n");
 			printf("\t--power - Use D0 (pin 2 of parallel port) to supply 5V power\n");
+			printf("\t-x - Read an emulated port instead of the hardware\n");
+			printf("\t-w - Record every change of the port, to play back with -x\n");
 			exit(1);
 		}
-		if(strcmp(argv[1], "--power") ==0) {
-			usePower = true;
-		}
 	}
 	
-#ifdef __linux__
-	//For use of ss as normal user
-	seteuid(0);
-	// Notify Linux that we want to have unfettered I/O port access
-	if(iopl(3)==-1) {
-		printf("Must be root to access I/O ports\n");
+	PortIO * io = getPortIO();
+	if(!io->open(PORT))
 		exit(1);
-	}
-#endif	
 	time_t t1,t2;
 	int i, k;
 	/* index 0 = Bit 8 = 
@@ -81,20 +74,28 @@ int main(int argc, char * argv[]) {
 		lastValue[i]=0;
 	}
 	//make sure there is no power on the data pins, just in case
-	Out32(0, PORT - 1);
+	io->out(PORT - 1, 0);
 	//power up D0 if needed
 	if(usePower) {
 		printf("Powering 5V rail...\n");
-		Out32(255, PORT);
+		io->out(PORT - 1, 255);
 	}
 
 	printf("\nReading on Port 0x%x\n", PORT);
 	
 	time(&t1);
 	printf("Please swipe card within 5 seconds\n");
+	Wordf start = edgeClock();
+	int last = -1;
 	do
 	{
-		k=Inp32(PORT);
+		k=io->in(PORT);
+		//write down when the port changed, and to what
+		if(record != NULL && k != last) {
+			fprintf(record, "%llu %02x\n",
+				(unsigned long long) (edgeClock() - start), k);
+			last = k;
+		}
 		for(i=0;i<5;i++)
 			//only store changes!
 			if( (k & ands[i]) != lastValue[i]) {
@@ -110,6 +111,8 @@ int main(int argc, char * argv[]) {
 	for(i=0;i<5;i++)
 		printf("%d ", fluxes[i]);
 	printf("\n");
+	if(record != NULL)
+		fclose(record);
 	return 1;
 	
 }
@@ -26,25 +26,11 @@
 #include "loader.h"
 #include "misc.h"
 #include "ssflags.h"
+#include "portio.h"
 
 /** commandline options, needed by Reader instances*/
 SSFlags ssFlags;
 
-// necessary I/O for a Windows build
-#ifdef _WIN32
- /* prototypes for Inp32out32.dll calls */
- short _stdcall Inp32(short PortAddress);
- void _stdcall Out32(short PortAddress, short data);
-#endif
-
-// necessary I/O for a Linux build
-#ifdef __linux__
- #include <sys/io.h>
- #include <sys/types.h>
- #include <unistd.h>
- #define Inp32 inb
-#endif
-
 int port;
 
 Reader * queryReader(int i) {
@@ -82,13 +68,13 @@ Reader * queryGameReader() {
 	}
 	
 	int port = promptForPort(1);
-	setupDirectIO();
+	PortIO * io = setupDirectIO(port);
 	
 	time(&t1);
 	printf("Please swipe card within 5 seconds\n");
 	do
 	{
-		k=Inp32(port);
+		k=io->in(port);
 		for(i=0;i<5;i++)
 			if( (k & ands[i]) != lastValue[i]) {
 				fluxes[i]++;
@@ -202,22 +188,16 @@ Reader * querySerialReader() {
 }
 			
 /**
- * calls necessary init functions for platform for direct i/o access
+ * gets at the port, through the hardware or an emulated port
+ * @param p port address
+ * @return where to read the port
  */
-void setupDirectIO()
+PortIO * setupDirectIO(int p)
 {
-	#ifdef __linux__
-	//If binary is set to +s and owner is root then become root
-	//else silently fail
-	//For use of ss as normal user
-	seteuid(0);
-
-	// Notify Linux that we want to have unfettered I/O port access
-	if(iopl(3)==-1) {
-		printf("Must be root to access I/O ports\n");
+	PortIO * io = getPortIO();
+	if(!io->open(p))
 		exit(1);
-	}
-	#endif
+	return io;
 }
 /**
  * sorts "deltas" in High -> low fashion
@@ -279,6 +259,13 @@ int main(int argc, char* argv[])
 	
 	printf("Stripe Snoop - Magstripe Reader Detector\n");
 	printf("Version 1.1\n\n");
+	//probe an emulated reader instead of the hardware
+	if(argc == 3 && strcmp(argv[1], "-x") == 0) {
+		EmulatedPort * emu = loadEmulatedPort(argv[2]);
+		if(emu == NULL)
+			exit(1);
+		setPortIO(emu);
+	}
 	do {
 		printf("Please select Interface:\n");
 		printf("1- Game port\n");
@@ -1,4 +1,5 @@
 #include "reader.h"
+#include "portio.h"
 
 Reader * queryReader(int i);
 
@@ -8,7 +9,7 @@ Reader * queryParallelReader();
 
 Reader * querySerialReader();
 
-void setupDirectIO();
+PortIO * setupDirectIO(int p);
 
 void sortByValue(long * fluxes, int * mask);
 
@@ -19,25 +19,14 @@
 #include "track.h"
 #include "misc.h"
 #include "bitstream.h"
+#include "streamdecoder.h"
+#include "portio.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-
-
-// necessary I/O for a Windows build
-#ifdef _WIN32
- /* prototypes for Inp32out32.dll calls */
- short _stdcall Inp32(short PortAddress);
- void _stdcall Out32(short PortAddress, short data);
-#endif
-
-// necessary I/O for a Linux build
-#ifdef __linux__
- #include <sys/io.h>
- #include <sys/types.h>
- #include <unistd.h>
- #define Inp32 inb
-#endif
+#include <utility>
+#include <thread>
+#include <chrono>
 
  
 char * createTag(char *n, char * v) {
@@ -65,6 +54,7 @@ Reader::Reader()
 	init = false;
 	readableTracks.clear();	
 	verbose = true;
+	timing = false;
 }
 
 char * Reader::getName() const {
@@ -82,6 +72,30 @@ void Reader::setVerbose(bool b) {
 	verbose = b;
 }
 
+/**
+ * turns timing of each clock edge on or off, for readers that see them.
+ * Set it before the first read
+ */
+void Reader::setTiming(bool b) {
+	timing = b;
+}
+
+/**
+ * readers that can't capture in the background just read when asked
+ * @return false
+ */
+bool Reader::startCapture() {
+	return false;
+}
+
+int Reader::getOverflows() const {
+	return 0;
+}
+
+int Reader::getDropped() const {
+	return 0;
+}
+
 
 bool Reader::canReadTrack(const int &t) const {
 	if(!readableTracks.empty()) {
@@ -106,6 +120,11 @@ DirectReader::DirectReader() : Reader() {
 	port = 0x379;
 	setName("Parallel Based Track 2 Reader");
 	usesCP = false;
+	ring = NULL;
+	io = NULL;
+	pool = new CapturePool();
+	density[0] = density[2] = BPI13;
+	density[1] = BPI2;
 	
 	CLK1 = CLK2 = CLK3 = 0;
 	DATA1 = DATA2 = DATA3 = 0;
@@ -114,6 +133,11 @@ DirectReader::DirectReader() : Reader() {
 DirectReader::DirectReader(int p, int cp, int c1, int d1,
 		           int c2, int d2, int c3, int d3) : Reader() {
 	port = p;
+	ring = NULL;
+	io = NULL;
+	pool = new CapturePool();
+	density[0] = density[2] = BPI13;
+	density[1] = BPI2;
 	if(cp > 0) {
 		usesCP = true;
 		CP = cp;
@@ -167,18 +191,21 @@ bool DirectReader::writeXML(char *fn) const {
 	if(canReadTrack(1)) {
 		fprintf(fout,"\t%s\n", createTag("CLK1",CLK1));
 		fprintf(fout,"\t%s\n", createTag("DATA1",DATA1));
+		fprintf(fout,"\t%s\n", createTag("DENSITY1",density[0]));
 	
 	}
 	fprintf(fout,"\t%s\n", createTag("track2",canReadTrack(2)));
 	if(canReadTrack(2)) {
 		fprintf(fout,"\t%s\n", createTag("CLK2",CLK2));
 		fprintf(fout,"\t%s\n", createTag("DATA2",DATA2));
+		fprintf(fout,"\t%s\n", createTag("DENSITY2",density[1]));
 	
 	}
 	fprintf(fout,"\t%s\n", createTag("track3",canReadTrack(3)));
 	if(canReadTrack(3)) {
 		fprintf(fout,"\t%s\n", createTag("CLK3",CLK3));
 		fprintf(fout,"\t%s\n", createTag("DATA3",DATA3));
+		fprintf(fout,"\t%s\n", createTag("DENSITY3",density[2]));
 	
 	}
 	fprintf(fout,"\t%s\n", createTag("card present",usesCP));
@@ -196,149 +223,433 @@ bool DirectReader::writeXML(char *fn) const {
 
 void DirectReader::readRaw() const {
 
-	//Are we using a platform that supports Direct I/O?
-	#if defined(_WIN32) || defined(__linux__)
 	if(!init) {
 		printf("Error! Hardware has not been initialized\n");
 		exit(1);
 	}
 
 	int e=0;
+	int clk, data;
+	trackLines(captureTrack(), clk, data);
 
 	if(usesCP) {
 		//wait for a card swipe!
-		while( (Inp32(port) & CP) != 0) {}
+		while( (io->in(port) & CP) != 0) {}
+		while( (io->in(port) & CP) != CP) {}
 		//Card Detected!
-		while( (Inp32(port) & CP) != CP) {
-			//trap the clock line
+		do {
+			//trap the clock line, unless the card goes away
 			do {
-				e=Inp32(port);
-			} while( (e & CLK2) !=0);
+				e=io->in(port);
+			} while( (e & clk) !=0 && (e & CP) == CP);
+			if( (e & CP) != CP)
+				break;
 			
-			if( (e & DATA2) ==0)
+			if( (e & data) ==0)
 				printf("1");
 			else
 				printf("0");
 			fflush(stdout);
 
 			do {
-				e=Inp32(port);
-			} while( (e & CLK2) != CLK2);
+				e=io->in(port);
+			} while( (e & clk) != clk);
 			//done trapping the clock line
-		}
+		} while( (e & CP) == CP);
+		printf("\n");
 	} else {
 		while(1) {
 			do {
-				e=Inp32(port);
-			}while( (e & CLK2) !=0);
-			if( (e & DATA2) ==0)
+				e=io->in(port);
+			}while( (e & clk) !=0);
+			if( (e & data) ==0)
 				printf("1");
 			else
 				printf("0");
 			fflush(stdout);
 			do
 			{
-				e=Inp32(port);
-			}while( (e & CLK2) != CLK2);
+				e=io->in(port);
+			}while( (e & clk) != clk);
 		}
 	} //end if usesCP
-	#else
-		printf("Program not compiled to support this hardware\n");
-		exit(1);
-	#endif
 }
 
-Card DirectReader::read() const
+void DirectReader::read(Card &theCard) const
 {
-	//Are we using a platform that supports Direct I/O?
-	#if defined(_WIN32) || defined(__linux__)
 	if(!init) {
 		printf("Error! Hardware has not been initialized\n");
 		exit(1);
 	}
 	
-	Bytef * tempBits = new Bytef[1024]; //keep this abstract
-	int e;
-	int size;
-	memset(tempBits,0,700);
+	TrackCapture caps[MAXTRACKS];
+	int n = wiredTracks(caps);
 		
 	printf("Waiting for Card\n");
-	if(usesCP) {
+	if(usesCP)
 		printf("Using CP!\n");
-		size = 0;
+	if(ring != NULL)
+		takeSwipe(caps, n);
+	else
+		captureSwipe(caps, n, true);
+	for(int i = 0; verbose && i < n; i++) {
+		if(caps[i].complete)
+			printf("Track %d: end sentinel and LRC went by, %d bits read\n",
+			       caps[i].track, caps[i].buf->getSize());
+	}
+	buildCard(caps, n, theCard);
+	freeCaptures(caps, n);
+	printf("retuning the card\n");
+}
+
+/**
+ * sets up a capture for every track the reader has wired, in track order.
+ * A reader with none is read as Track 2, like it always was
+ *
+ * @param caps room for MAXTRACKS
+ * @return how many were set up
+ */
+int DirectReader::wiredTracks(TrackCapture * caps) const {
+	int tracks[MAXTRACKS];
+	int n = 0;
+	int i, clk, data;
+	for(i = 1; i <= MAXTRACKS; i++) {
+		trackLines(i, clk, data);
+		if(clk != 0)
+			tracks[n++] = i;
+	}
+	if(n == 0)
+		tracks[n++] = 2;
+	for(i = 0; i < n; i++) {
+		TrackCapture &c = caps[i];
+		c.track = tracks[i];
+		trackLines(c.track, c.clk, c.data);
+		c.buf = pool->acquire(captureBits(c.track));
+		c.complete = false;
+	}
+	return n;
+}
+
+void DirectReader::freeCaptures(TrackCapture * caps, const int &n) const {
+	for(int i = 0; i < n; i++)
+		pool->release(caps[i].buf);
+}
+
+/**
+ * the capture loop, reading the clock at each edge if TIMED
+ */
+template <bool TIMED>
+void DirectReader::captureSwipeWith(TrackCapture * caps, const int &n,
+				    bool decode) const {
+	StreamDecoder decoders[MAXTRACKS];
+	int held[MAXTRACKS];
+	Wordf lastEdge[MAXTRACKS];
+	int stopped = 0;
+	int idle = 0;
+	bool started = false;
+	int e, last, i;
+
+	for(i = 0; i < n; i++) {
+		caps[i].buf->reset(captureBits(caps[i].track));
+		caps[i].complete = false;
+		held[i] = 0;
+		//without CP, stop as soon as a whole track has gone by
+		decoders[i] = StreamDecoder(isoFormat(caps[i].track));
+	}
+	if(usesCP) {
 		//wait for a card swipe!
-		while( (Inp32(port) & CP) != 0) {}
-		while( (Inp32(port) & CP) != CP) {}
-		e=Inp32(port);
-		//Card Detected!
-		while( (e & CP) != 0) {
-			//trap the clock line
-			do {
-				e=Inp32(port);
-			} while( (e & CLK2) !=0);
+		while( (io->in(port) & CP) != 0) {}
+		while( (io->in(port) & CP) != CP) {}
+	}
+	last = io->in(port);
+	//Card Detected!
+	while(stopped < n) {
+		e = io->in(port);
+		int changed = e ^ last;
+		for(i = 0; i < n; i++) {
+			TrackCapture &c = caps[i];
+			held[i] = (changed & c.data) ? 0 : held[i] + 1;
+			//trap the falling edge of the clock line
+			if( (changed & last & c.clk) == 0 || c.buf->isFull() ||
+			    (c.complete && !usesCP))
+				continue;
 			//store the value
-			tempBits[size]=e;
-			size++;
-			if(size==700) {
+			c.buf->add(e, (held[i] < MAXMARGIN) ? held[i] : MAXMARGIN);
+			if(TIMED) {
+				Wordf now = io->now();
+				c.buf->getTimes().add((c.buf->getSize() > 1) ?
+						      now - lastEdge[i] : 0);
+				lastEdge[i] = now;
+			}
+			if(decode)
+				c.complete = decoders[i].push((e & c.data) == 0);
+			//with CP, a ticket with more records after the first keeps
+			//going until the card is out
+			if(c.buf->isFull() || (c.complete && !usesCP))
+				stopped++;
+			started = started || (e & c.data) == 0;
+			idle = 0;
+		}
+		last = e;
+		if(usesCP) {
+			if( (e & CP) == 0)
+				break;
+		} else if(++idle > IDLEPOLLS) {
+			if(started)
 				break;
+			//only zeros, like the tail of the last swipe after it was
+			//complete, so keep waiting for a card
+			for(i = 0; i < n; i++) {
+				caps[i].buf->reset(captureBits(caps[i].track));
+				decoders[i].reset();
 			}
-			do {
-				e=Inp32(port);
-			} while( (e & CLK2) != CLK2);
-			//done trapping the clock line
+			stopped = 0;
+			idle = 0;
 		}
-	} else {
-		for(size = 0; size < 240; size++) {
-			//trap the clock line
-			do {
-				e=Inp32(port);
-			} while( (e & CLK2) !=0);
-			//store the value
-			tempBits[size]=e;
-			do {
-				e=Inp32(port);
-			} while( (e & CLK2) != CLK2);
-			//done trapping the clock line
+	}
+}
+
+/**
+ * polls the port through one swipe, capturing every track at once. Each
+ * read of the port is split between the tracks: a track gets a bit when
+ * its clock line goes low, and keeps count of how long its data line has
+ * held still for the timing margin. A track stops at its bit limit or,
+ * without CP, once a whole track has gone by, and the swipe ends when all
+ * of them have stopped, CP goes away, or (without CP) the clocks go quiet
+ * after a 1 bit. With CP every record on the stripe is read
+ *
+ * @param caps tracks to capture, from wiredTracks()
+ * @param n how many
+ * @param decode whether to decode as it goes, which tells a track that
+ *        is complete and without CP stops it there
+ */
+void DirectReader::captureSwipe(TrackCapture * caps, const int &n,
+				bool decode) const {
+	//two copies of the loop, so the one without timing has no trace of it
+	if(timing)
+		captureSwipeWith<true>(caps, n, decode);
+	else
+		captureSwipeWith<false>(caps, n, decode);
+}
+
+/**
+ * waits for the capture thread to finish a swipe and takes it off the ring,
+ * decoding each track as it goes to see if a whole one went by
+ *
+ * @param caps tracks to fill in, from wiredTracks()
+ * @param n how many
+ */
+void DirectReader::takeSwipe(TrackCapture * caps, const int &n) const {
+	StreamDecoder decoders[MAXTRACKS];
+	Sample s;
+	int i;
+	for(i = 0; i < n; i++) {
+		caps[i].buf->reset(captureBits(caps[i].track));
+		caps[i].complete = false;
+		decoders[i] = StreamDecoder(isoFormat(caps[i].track));
+	}
+	while(1) {
+		if(!ring->pop(s)) {
+			//the ring holds many swipes, so there's no hurry
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			continue;
+		}
+		if(s.flags & SAMPLE_END)
+			break;
+		for(i = 0; i < n; i++) {
+			TrackCapture &c = caps[i];
+			if(c.track == s.track) {
+				c.buf->add(s.port, s.margin);
+				if(timing)
+					c.buf->getTimes().add(s.delta);
+				c.complete = decoders[i].push((s.port & c.data) == 0);
+			}
 		}
 	}
+}
+
+/**
+ * strips each track of a swipe down to its bits and puts them in a Card,
+ * clearing out the last swipe's
+ *
+ * @param caps captured tracks
+ * @param n how many
+ * @param theCard card to fill in
+ */
+void DirectReader::buildCard(const TrackCapture * caps, const int &n,
+			     Card &theCard) const {
+	theCard.clear();
 	printf("Creating Bitstream...\n");
-	//strip it to a binary
-	for(int k = 0; k < size ;k++) {
-		tempBits[k] = (tempBits[k] & DATA2);
-		if(tempBits[k]==0) {
-			tempBits[k]=1;
+	for(int i = 0; i < n; i++) {
+		const TrackCapture &c = caps[i];
+		//strip it to a binary, packing it as we go
+		const Bytef * tempBits = c.buf->getSamples();
+		Bitstream bits(c.buf->getSize());
+		for(int k = 0; k < c.buf->getSize() ;k++) {
+			if( (tempBits[k] & c.data) == 0) {
+				bits.setBit(k, 1);
+			}
+		}
+		//a blank stripe never sets a bit
+		if(bits.firstSet(0) < 0) {
+			theCard.addMissingTrack(c.track);
 		} else {
-			tempBits[k]=0;
+			//create the Track, with how sure we were of each bit
+			Track t(bits, c.track);
+			t.setMargins(c.buf->getMargins());
+			if(timing)
+				t.setEdgeTimes(c.buf->getTimes());
+			theCard.addTrack(std::move(t));
 		}
 	}
-	//create the Track
-	Track t2(tempBits, size, 2);
-	Card theCard;
-	theCard.addTrack(t2);
-	printf("retuning the card\n");
-	return theCard;
-	
-	#else
-		printf("Not compiled with hardware Interface Support!\n");
-		exit(1);
-	#endif
+}
 
+/**
+ * starts a thread that does nothing but capture swipes and push them onto
+ * the ring, so a swipe that comes while the last one is still being
+ * decoded and printed isn't missed. read() takes them off the ring from
+ * then on
+ *
+ * @return false if the hardware isn't ready
+ */
+bool DirectReader::startCapture() {
+	if(!init) {
+		printf("Error! Hardware has not been initialized\n");
+		return false;
+	}
+	if(ring != NULL)
+		return true;
+	ring = new SampleRing();
+	std::thread(&DirectReader::captureLoop, this).detach();
+	if(verbose)
+		printf("Capturing on a thread of its own\n");
+	return true;
+}
+
+/**
+ * the capture thread. A swipe is pushed only once it is over, and all at
+ * once: if the decoding side has fallen so far behind that it doesn't fit,
+ * the whole swipe is dropped and counted rather than half of one passed on.
+ * It leaves even the stream decoding to takeSwipe(), and so reads each
+ * swipe until CP goes away or the clocks go quiet
+ */
+void DirectReader::captureLoop() {
+	TrackCapture caps[MAXTRACKS];
+	int n = wiredTracks(caps);
+	int room = 1;
+	int i, k;
+	for(i = 0; i < n; i++)
+		room += captureBits(caps[i].track);
+	Sample * swipe = new Sample[room];
+	while(1) {
+		captureSwipe(caps, n, false);
+		int size = 0;
+		for(i = 0; i < n; i++) {
+			const CaptureBuffer &b = *caps[i].buf;
+			int at = 0;
+			for(k = 0; k < b.getSize(); k++) {
+				Wordf delta = 0;
+				if(timing)
+					at = b.getTimes().next(at, delta);
+				swipe[size].port = b.getSamples()[k];
+				swipe[size].margin = b.getMargins()[k];
+				swipe[size].delta = (delta < 0xFFFFFFFFULL) ?
+						    (unsigned int) delta : 0xFFFFFFFFU;
+				swipe[size].track = caps[i].track;
+				swipe[size].flags = 0;
+				size++;
+			}
+		}
+		swipe[size].port = 0;
+		swipe[size].margin = 0;
+		swipe[size].track = 0;
+		swipe[size].flags = SAMPLE_END;
+		swipe[size].delta = 0;
+		ring->push(swipe, size + 1);
+	}
 }
 
+/**
+ * @return swipes the capture thread dropped because the ring was full
+ */
+int DirectReader::getOverflows() const {
+	return (ring != NULL) ? ring->getOverflows() : 0;
+}
 
+/**
+ * @return samples in the swipes that were dropped, end markers included
+ */
+int DirectReader::getDropped() const {
+	return (ring != NULL) ? ring->getDropped() : 0;
+}
+
+/**
+ * @return the track raw mode reads: Track 2 if it's wired up, then
+ * Track 3, then Track 1
+ */
+int DirectReader::captureTrack() const {
+	if(CLK2 != 0)
+		return 2;
+	if(CLK3 != 0)
+		return 3;
+	if(CLK1 != 0)
+		return 1;
+	return 2;
+}
+
+/**
+ * gets the port bits a track's clock and data lines are on
+ */
+void DirectReader::trackLines(const int &t, int &clk, int &data) const {
+	switch(t) {
+		case 1:
+			clk = CLK1;
+			data = DATA1;
+			break;
+		case 3:
+			clk = CLK3;
+			data = DATA3;
+			break;
+		default:
+			clk = CLK2;
+			data = DATA2;
+	}
+}
+
+/**
+ * works out the most bits to read from a track: as many as fit along a
+ * card at the track's density. Without CP a swipe that never finishes
+ * stops there, so it also needs room for the leading zeros. With CP the
+ * swipe ends when CP goes away, so this is only a limit, with room for a
+ * noisy head
+ *
+ * @param t track number
+ * @return bits to read
+ */
+int DirectReader::captureBits(const int &t) const {
+	int bits = density[t - 1] * STRIPEMILS / 1000;
+	return (usesCP) ? CPLIMIT * bits + CPSLACK : bits + LEADBITS;
+}
+
+/**
+ * sets a track's recording density, from the config file
+ *
+ * @param t track number
+ * @param bpi bits per inch, ignored if it isn't positive
+ */
+void DirectReader::setDensity(const int &t, const int &bpi) {
+	if(t >= 1 && t <= MAXTRACKS && bpi > 0)
+		density[t - 1] = bpi;
+}
+
+/**
+ * gets at the port, through whatever getPortIO() is: the hardware, or an
+ * emulated port set in its place
+ */
 bool DirectReader::initReader() {
-	#ifdef __linux__
-	//If binary is set to +s and owner is root then become root
-	//else silently fail
-	//For use of ss as normal user
-	seteuid(0);
-	
-	// Notify Linux that we want to have unfettered I/O port access
-	if(iopl(3)==-1) {
-		printf("Must be root to access I/O ports\n");
+	io = getPortIO();
+	if(!io->open(port))
 		return false;
-	}
-	#endif
 	
 	if(verbose) {
 		printf("Reader Hardware: Using port 0x%x\n",port);
@@ -399,12 +710,12 @@ void SerialReader::readRaw() const {
 	exit(1);
 }
 
-Card SerialReader::read() const
+void SerialReader::read(Card &theCard) const
 {
 	char buffer[1024];
 	memset(buffer,0,1024);
 
-	Card theCard;
+	theCard.clear();
 	
 	char * track1 = NULL;
 	char * track2 = NULL;
@@ -453,8 +764,7 @@ Card SerialReader::read() const
 		if(strcmp(track1,"\%E?") ==0 || strcmp(track1,"%N?") == 0 ) {
 			theCard.addMissingTrack(1);
 		} else {
-			Track tmp(track1, 1);
-			theCard.addTrack(tmp);
+			theCard.addTrack(Track(track1, 1));
 		}	
 	}
 	//Track 2
@@ -465,10 +775,9 @@ Card SerialReader::read() const
 	} else if(canReadTrack(2)) {
 		//catch serial readers reporting Empty Tracks
 		if(strcmp(track2,";E?") ==0 || strcmp(track2,";N?") == 0 ) {
-			theCard.addMissingTrack(1);
+			theCard.addMissingTrack(2);
 		} else {
-			Track tmp(track2, 2);
-			theCard.addTrack(tmp);
+			theCard.addTrack(Track(track2, 2));
 		}	
 	}
 
@@ -482,11 +791,9 @@ Card SerialReader::read() const
 		if(strcmp(track3,"+E?") ==0 || strcmp(track3,"+N?") == 0 ) {
 			theCard.addMissingTrack(3);
 		} else {
-			Track tmp(track3, 3);
-			theCard.addTrack(tmp);
+			theCard.addTrack(Track(track3, 3));
 		}	
 	}
-	return theCard;
 }
 
 void SerialReader::setCRFlag(bool b) {
@@ -8,9 +8,50 @@
  */
 
 #include "card.h"
+#include "spscring.h"
+#include "capturepool.h"
+#include "portio.h"
+#include <stdio.h>
 
 typedef std::vector<int>  intVec;
 
+//how many bits DirectReader reads from a track
+#define STRIPEMILS 3375	//length of a card, thousandths of an inch
+#define BPI13 210	//ISO density of Tracks 1 and 3, bits per inch
+#define BPI2 75		//ISO density of Track 2
+#define LEADBITS 40	//without CP: leading zeros allowed past the longest track
+#define CPLIMIT 3	//with CP: times the longest track before giving up
+#define CPSLACK 100
+#define IDLEPOLLS 100000	//without CP: polls with no clock at all that end a swipe
+
+#define MAXMARGIN 255	//timing margins are kept in a byte
+
+//what the capture thread hands to the decoding thread, one per clocked bit
+#define RINGSIZE 65536	//samples it can get ahead by, must be a power of 2
+#define SAMPLE_END 1	//not a bit, marks the end of a swipe
+
+class Sample {
+public:
+	Bytef port;	//port byte when the clock strobed
+	Bytef margin;	//polls the data line had held still
+	Bytef track;	//track whose clock strobed
+	Bytef flags;	//SAMPLE_*
+	unsigned int delta;	//ns since the track's last strobe, if timing
+};
+
+typedef SpscRing<Sample, RINGSIZE> SampleRing;
+
+//one track's part of a swipe, all tracks are sampled from the same port reads
+class TrackCapture {
+public:
+	int track;	//track number
+	int clk;	//port bits of its clock and data lines
+	int data;
+	CaptureBuffer * buf;	//port byte at each strobe of its clock, and
+				//polls its data line had held still by then
+	bool complete;	//end sentinel and a good LRC went by
+};
+
 //abstarct!
 class Reader {
 
@@ -20,6 +61,7 @@ public:
 	void setName(char *);
 	
 	void setVerbose(bool);
+	void setTiming(bool);
 	
 	bool canReadTrack(const int &) const;
 	void setCanReadTrack(const int&);
@@ -27,7 +69,10 @@ public:
 	//-----------funcs
 	virtual void readRaw() const =0; //read in raw mode from the interface
         virtual bool initReader() = 0;//init hardware
-	virtual Card read() const =0; //read from the hardware interface!	
+	virtual bool startCapture(); //capture on a thread of its own
+	virtual int getOverflows() const; //swipes lost because decoding fell behind
+	virtual int getDropped() const; //samples in them
+	virtual void read(Card &) const =0; //read from the hardware interface!	
 	virtual bool writeXML(char *) const =0; //write this object as XML from disk;
 protected:
 	char * name;
@@ -37,6 +82,7 @@ protected:
 	//internal variables
 	bool init;	//used to track if hardware is inited
 	bool verbose;	//am I being verbose?
+	bool timing;	//time each clock edge?
 
 };
 
@@ -50,13 +96,33 @@ public:
 	DirectReader(int, int, int, int, int, int, int, int);
 	virtual void readRaw() const; //read in raw mode from the interface
         virtual bool initReader();
-	virtual Card read() const;	//read from the hardware interface!	
+	virtual void read(Card &) const;	//read from the hardware interface!	
 	virtual bool writeXML(char *) const;
+	virtual bool startCapture();
+	virtual int getOverflows() const;
+	virtual int getDropped() const;
+	void setDensity(const int&, const int&);
 	
 protected:
 
 	int port;
 	bool usesCP;
+	PortIO * io;	//where the port is read, once initReader() has run
+	SampleRing * ring;	//filled by the capture thread once it's started
+	CapturePool * pool;	//capture buffers, kept between swipes
+	int density[MAXTRACKS];	//bits per inch of each track
+
+	int captureTrack(void) const;
+	void trackLines(const int&, int&, int&) const;
+	int captureBits(const int&) const;
+	int wiredTracks(TrackCapture *) const;
+	void freeCaptures(TrackCapture *, const int&) const;
+	void captureSwipe(TrackCapture *, const int&, bool) const;
+	template <bool TIMED>
+	void captureSwipeWith(TrackCapture *, const int&, bool) const;
+	void takeSwipe(TrackCapture *, const int&) const;
+	void buildCard(const TrackCapture *, const int&, Card &) const;
+	void captureLoop(void);
 	
 	int CP;
 	int CLK1;
@@ -80,14 +146,14 @@ public:
 	void setCRFlag(bool);
 	virtual void readRaw() const; //read in raw mode from the interface
         virtual bool initReader();
-	virtual Card read() const;	//read from the hardware interface!	
+	virtual void read(Card &) const;	//read from the hardware interface!	
 	virtual bool writeXML(char *) const;
 	
 protected:
 
 	char * device;
 	FILE * fin;
-	bool SerialReader::validInput(const char *) const;
+	bool validInput(const char *) const;
 	char * parseTrack(const char *, const char, const char) const;
         bool flagCR;
 };
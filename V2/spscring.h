@@ -0,0 +1,75 @@
+/*
+ * SpscRing - lock-free ring buffer between one producer and one consumer
+ *
+ * The capture thread is the only one that pushes and the decoding thread the
+ * only one that pops, so each end owns one index and only reads the other.
+ * Nothing ever waits: a push that doesn't fit is refused and counted, so the
+ * thread sampling the port never stalls behind the one printing results.
+ * N must be a power of 2 so the free running indexes wrap cleanly.
+ */
+
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <atomic>
+
+#define CACHELINE 64	//keeps the two ends' indexes from sharing a line
+
+template <class T, int N>
+class SpscRing {
+public:
+	SpscRing() : head(0), tail(0), overflows(0), dropped(0) {}
+
+	/**
+	 * pushes all of n items, or none of them if they don't all fit
+	 * @return false if the ring didn't have room
+	 */
+	bool push(const T * items, const int &n) {
+		unsigned int h = head.load(std::memory_order_relaxed);
+		unsigned int used = h - tail.load(std::memory_order_acquire);
+		if(n > (int) (N - used)) {
+			overflows.fetch_add(1, std::memory_order_relaxed);
+			dropped.fetch_add(n, std::memory_order_relaxed);
+			return false;
+		}
+		for(int i = 0; i < n; i++)
+			slots[(h + i) % N] = items[i];
+		head.store(h + n, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * takes the oldest item
+	 * @return false if the ring is empty
+	 */
+	bool pop(T &item) {
+		unsigned int t = tail.load(std::memory_order_relaxed);
+		if(head.load(std::memory_order_acquire) == t)
+			return false;
+		item = slots[t % N];
+		tail.store(t + 1, std::memory_order_release);
+		return true;
+	}
+
+	/** @return pushes refused because the ring was full */
+	int getOverflows() const {
+		return overflows.load(std::memory_order_relaxed);
+	}
+
+	/** @return items in the pushes that were refused */
+	int getDropped() const {
+		return dropped.load(std::memory_order_relaxed);
+	}
+
+private:
+	T slots[N];
+	char pad0[CACHELINE];
+	std::atomic<unsigned int> head;	//next slot to push, producer's
+	char pad1[CACHELINE];
+	std::atomic<unsigned int> tail;	//next slot to pop, consumer's
+	char pad2[CACHELINE];
+	std::atomic<int> overflows;	//producer's
+	std::atomic<int> dropped;
+};
+
+#endif
@@ -26,8 +26,14 @@ SSFlags::SSFlags()
 	FORCE=false;
 	CONFIG = false;
 	LOOP=false;
+	CORRECT=false;
+	SOFT=false;
+	TIMING=false;
+	EMULATED=false;
+	BENCHMARK=false;
 	fileinput = NULL;
 	config = NULL;
+	emulated = NULL;
 }
 
 void SSFlags::setFileInput(char * s) {
@@ -46,5 +52,13 @@ void SSFlags::setConfigFile(char * s) {
     strcpy(config,s);
 }
 
+void SSFlags::setEmulatedFile(char * s) {
+    if(emulated != NULL)
+        delete [] emulated;
+    emulated = new char [strlen(s) + 1];
+    memset(emulated,0,strlen(s) + 1);
+    strcpy(emulated,s);
+}
+
 
 
@@ -10,6 +10,7 @@ public:
 	SSFlags(); //constructor
         void setFileInput(char *);
 	void setConfigFile(char *);
+	void setEmulatedFile(char *);
 public:
 	bool VERBOSE; //verbose flag
 	bool RAW;     //RAW Flag
@@ -17,8 +18,14 @@ public:
 	bool FORCE;
 	bool CONFIG;
 	bool LOOP;
+	bool CORRECT; //single bit error correction
+	bool SOFT;    //soft decision repair from timing margins
+	bool TIMING;  //time each clock edge
+	bool EMULATED; //read an emulated port instead of the hardware
+	bool BENCHMARK; //find the fastest clock the emulated port is read at
         char * fileinput;
 	char * config;
+	char * emulated;
 	
 };
 
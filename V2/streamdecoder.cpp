@@ -0,0 +1,129 @@
+/**
+ * @file streamdecoder.cpp
+ * @brief Decodes a track one bit at a time, while it is being captured.
+ *
+ * Each bit goes into the code word being built. When a code word is full
+ * it is checked the same way scanWith() checks it: the start sentinel
+ * must come first, every character must pass parity, and the code word
+ * after the end sentinel must be the LRC. The first failure ends the
+ * decode, and push() only returns true for a track that passed all of it.
+ *
+ * @author Acidus (acidus@msblabs.org)
+ *
+ * This file is part of Stripe Snoop (http://stripesnoop.sourceforge.net)
+ *
+ * Stripe Snoop is licensed under the GPL. See COPYING for more info
+ *
+ * Copyright (C) 2005 Acidus, Most Significant Bit Labs
+ */
+
+#include "streamdecoder.h"
+
+/**
+ * @param format FORMAT_* the track is expected to be in
+ */
+StreamDecoder::StreamDecoder(const int &format) {
+	f = &formatEntry(format);
+	reset();
+}
+
+/**
+ * starts over, for the next swipe
+ */
+void StreamDecoder::reset() {
+	state = STREAM_WAIT;
+	status = DECODE_NOSS;
+	pos = 0;
+	chars = 0;
+	have = 0;
+	code = 0;
+	lrc = 0;
+}
+
+/**
+ * takes the next bit of the track
+ *
+ * @param bit 1 or 0
+ * @return true once the end sentinel and a good LRC have been read
+ */
+bool StreamDecoder::push(const int &bit) {
+	if(state == STREAM_DONE)
+		return status == DECODE_OK;
+	pos++;
+	if(state == STREAM_WAIT) {
+		if(bit == 0)
+			return false;
+		state = STREAM_CHARS;
+	}
+	code = (code << 1) | (bit & 1);
+	if(++have < f->bits)
+		return false;
+
+	const int pb = f->parityBits;
+	Wordf c = code;
+	have = 0;
+	code = 0;
+	if(state == STREAM_LRC) {
+		//LRC gets the same parity, so borrow the table to work it out
+		Wordf expect = lrc;
+		if(pb != 0)
+			expect = (lrc << 1) | (f->table[lrc << 1].parity ? 0 : 1);
+		finish((c == expect) ? DECODE_OK : DECODE_LRC);
+		return status == DECODE_OK;
+	}
+	if(chars == 0 && c != f->ss) {
+		finish(DECODE_NOSS);
+		return false;
+	}
+	if(!f->table[c].parity) {
+		finish(DECODE_PARITY);
+		return false;
+	}
+	//Just XOR the Data Bits of each character, not the parity bit
+	lrc ^= c >> pb;
+	chars++;
+	if(c == f->es)
+		state = STREAM_LRC;
+	else if(f->maxChars > 0 && chars >= f->maxChars)
+		finish(DECODE_NOES); //longer than the track can be
+	return false;
+}
+
+void StreamDecoder::finish(const int &s) {
+	status = s;
+	state = STREAM_DONE;
+}
+
+/**
+ * @return true if nothing more can be learned from more bits
+ */
+bool StreamDecoder::isDone() const {
+	return state == STREAM_DONE;
+}
+
+/**
+ * @return true if a whole track with a good LRC has been read
+ */
+bool StreamDecoder::isComplete() const {
+	return state == STREAM_DONE && status == DECODE_OK;
+}
+
+/**
+ * @return DECODE_* of the decode. Until it's done, what is still missing
+ */
+int StreamDecoder::getStatus() const {
+	switch(state) {
+		case STREAM_CHARS:
+			return DECODE_NOES;
+		case STREAM_LRC:
+			return DECODE_NOLRC;
+	}
+	return status;
+}
+
+/**
+ * @return bits pushed so far
+ */
+int StreamDecoder::getPos() const {
+	return pos;
+}
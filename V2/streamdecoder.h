@@ -0,0 +1,48 @@
+/*
+ * StreamDecoder - decodes a track a bit at a time, as a reader clocks it in
+ *
+ * DirectReader pushes each bit into one of these while it captures, so
+ * with no CP line it can stop as soon as the end sentinel and a good LRC
+ * have gone by instead of reading to its bit limit. With CP it reads on
+ * while the card is in, for tickets with more than one record. Capturing
+ * on a thread of its own, the bits are pushed as read() takes them off the
+ * ring instead, and only say whether a whole track went by. Only a forwards swipe can finish early: read
+ * backwards the LRC comes first, and can't be checked until the end. The
+ * captured bits still go through Track::decode() either way.
+ */
+
+#ifndef STREAMDECODER_H
+#define STREAMDECODER_H
+
+#include "trackformat.h"
+
+//decoder states
+#define STREAM_WAIT 0	//leading zeros, waiting for the first 1 bit
+#define STREAM_CHARS 1	//reading characters
+#define STREAM_LRC 2	//end sentinel read, waiting for the LRC
+#define STREAM_DONE 3	//finished, see getStatus()
+
+class StreamDecoder {
+public:
+	StreamDecoder(const int& = FORMAT_TRACK2);
+	void reset(void);
+	bool push(const int&);
+	bool isDone(void) const;
+	bool isComplete(void) const;
+	int getStatus(void) const;
+	int getPos(void) const;
+
+private:
+	const FormatEntry * f;
+	int state;	//STREAM_*
+	int status;	//DECODE_* once done
+	int pos;	//bits pushed so far
+	int chars;	//characters read, start sentinel included
+	int have;	//bits of the code word collected
+	Wordf code;	//code word so far, first bit most significant
+	Wordf lrc;	//data bits of every character so far, XORed
+
+	void finish(const int&);
+};
+
+#endif
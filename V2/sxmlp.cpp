@@ -132,13 +132,37 @@ char * SXMLP::elementValue(char *s) {
 		if(s[j] == '>')
 			flag = 1;;
 	}
+	*a = '\0';
+	decodeEntities(t);
 	//printf("element value is \"%s\"\n", t);
 	return t;
 }
 
+/**
+ * replaces &lt; &gt; and &amp; in place, so values can hold those characters
+ */
+void SXMLP::decodeEntities(char *s) {
+	char * out = s;
+	while(*s) {
+		if(strncmp(s, "&lt;", 4) == 0) {
+			*out++ = '<';
+			s += 4;
+		} else if(strncmp(s, "&gt;", 4) == 0) {
+			*out++ = '>';
+			s += 4;
+		} else if(strncmp(s, "&amp;", 5) == 0) {
+			*out++ = '&';
+			s += 5;
+		} else {
+			*out++ = *s++;
+		}
+	}
+	*out = '\0';
+}
+
 bool SXMLP::loadFile(char *filename) {
 	
-	char * buffer = new char[80];	
+	char * buffer = new char[LINESIZE];	
 	FILE * fin;
 	
 	if ( (fin = fopen(filename,"r")) == NULL) {
@@ -147,7 +171,7 @@ bool SXMLP::loadFile(char *filename) {
 	}
 
 	//is this an xml file?
-	if (fgets(buffer,80,fin) == NULL) {
+	if (fgets(buffer,LINESIZE,fin) == NULL) {
 		printf("Error reading file\n");
 		return false;
 	}
@@ -157,8 +181,8 @@ bool SXMLP::loadFile(char *filename) {
 	}
 	
 	do {
-		memset(buffer,0,80);
-		fgets(buffer,80,fin);
+		memset(buffer,0,LINESIZE);
+		fgets(buffer,LINESIZE,fin);
 		if (strlen(buffer) > 0) {
 			buffer[strlen(buffer)-1] = '\0';
 			buffer = trimSpaces(buffer);
@@ -6,6 +6,8 @@
 
 typedef std::queue<char *>  stringQ;
 
+#define LINESIZE 256	//longest line we can read
+
 
 class SXMLP {
 public:
@@ -26,6 +28,7 @@ private:
 	int isElement(char *);
 	char * elementName(char *);
 	char * elementValue(char *);
+	void decodeEntities(char *);
 		
 };
 /*
@@ -28,19 +28,22 @@ extern SSFlags ssFlags;
 
 // ================================================================= TESTS
 /*
- * bool mod10check(char *card)
+ * bool mod10check(const FieldView &card)
  *
  * Performs a Luhn (MOD10) check on the account number passed
- * as a string of characters and returns the result
+ * as a field of characters and returns the result
  *
- * card - string of characters containing an account number
+ * card - field containing an account number. Only its leading digits
+ *        are checked
  * returns - Whether it passed MOD10 or not
  */
 
-bool mod10check(char *card)
+bool mod10check(const FieldView &card)
 {
-	unsigned char tmp, sum, i, j;
-	sum = i = j = 0;
+	unsigned char tmp, sum, j;
+	int i;
+	sum = j = 0;
+	i = 0;
 	//count the card digits
 	while(card[i] >= '0' && card[i] <= '9')
 		i++;
@@ -59,7 +62,7 @@ bool mod10check(char *card)
 	return false;
 }
 /*
- * bool isMonth(char * d);
+ * bool isMonth(const char * d);
  *
  * Checks to see if character string contains a number representation
  * of a month or notaracters and returns the result
@@ -67,7 +70,7 @@ bool mod10check(char *card)
  * d - string of 2 characters representing a month
  * returns - Whether it is a month
  */
-bool isMonth(char * d) {
+bool isMonth(const char * d) {
 	char tmp[3] = {0,0,0};
 	int i;
 	//make sure we only have numbers
@@ -245,50 +248,56 @@ char * monthName(int x) {
 }
 
 /*
- * char * formatter(char * format, char * n);
+ * char * formatter(const char * format, const FieldView &n);
  *
  * returns a string of numbers that are spaced/divided according to a
  * formatting string provided
  *
  * format - format String that shows how numbers are divided
             (ie "XXX-XX-XXXX" for an SSN);
+ * n - the numbers. If it runs out first, the string ends there
  * returns - correctly formatted numeric string
  */
-char * formatter(char * format, char * n) {
+char * formatter(const char * format, const FieldView &n) {
 	unsigned int i=0;
 	int k=0;
 	char * foo = new char[strlen(format)+1];
 	for(i=0;i<strlen(format);i++)
 	{
 		if(format[i]=='X') {
+			if(k >= n.length)
+				break;
 			foo[i]=n[k];
 			k++;
 		}
 		else
 			foo[i]=format[i];
 	}
+	foo[i]='\0';
 	return foo;
 }
 /* only recognize:
    YYMM
 */
-char * extractDate(char * format, char * n) {
+char * extractDate(const char * format, const FieldView &n) {
 	
 	char * date = NULL;
 	
 	if(strcmp(format,"YYMM")==0) {
 	       char temp[64];
 	       memset(temp,0,64);
-	       strncpy(temp,n,2);
+	       temp[0] = n[0];
+	       temp[1] = n[1];
 	       int year = atoi(temp);
 	       year = expandYear(year);
 	     
 	       memset(temp,0,64);
-	       strncpy(temp,&n[2],2);
+	       temp[0] = n[2];
+	       temp[1] = n[3];
 	       int month = atoi(temp);
 	       sprintf(temp,"%s %d", monthName(month), year);
 
-	       date = new char(strlen(temp)+1);
+	       date = new char[strlen(temp)+1];
 	       strcpy(date, temp);
 	       
 	}	       
@@ -319,7 +328,7 @@ void trimSpaces(char *s) {
 	
 /* "L/F M"
  */
-char * extractName(char * format, char *n) {
+char * extractName(const char * format, char *n) {
 	char * name = NULL;
         char temp[96];
 	char * t;
@@ -358,7 +367,7 @@ char * extractName(char * format, char *n) {
 		
 		//form final name
 		memset(temp, 0, 96);
-		if(t == '\0') //no middle
+		if(*t == '\0') //no middle
 			m = false;
 		else {
 			t++;
@@ -464,7 +473,7 @@ char * extractName(char * format, char *n) {
 }
 
 
-char * bankLookup(char * fn, char * s, int len) {
+char * bankLookup(const char * fn, const FieldView &s, int len) {
 	
 	FILE * fin;
 	char * bankName = NULL;
@@ -480,7 +489,7 @@ char * bankLookup(char * fn, char * s, int len) {
 			fgets(tmp,80,fin);
 			//ignore comments (starts with #)
 			if(strlen(tmp)>6 && *tmp != '#') {
-				if( strncmp(s,tmp,len) == 0) {
+				if(s.length >= len && strncmp(s.chars,tmp,len) == 0) {
 					int newLen = strlen(&tmp[len+1]);
 					bankName = new char[newLen+1];
 					memset(bankName, 0, newLen+1);
@@ -515,7 +524,7 @@ char numToAlpha(int i)
 	return alphabet[i - 1];
 }
 
-int svIndexLookup(char *fn, char * s, int len) {
+int svIndexLookup(char *fn, const char * s, int len) {
 	
 	FILE * fin;
 	if( (fin=fopen(fn,"r")) == NULL) {
@@ -5,6 +5,8 @@
 #ifndef TESTFUNCS_H
 #define TESTFUNCS_H
 
+#include "track.h"
+
 #define VISABANKNAMES "data/visa-pre.csv"
 #define MASTERCARDBANKNAMES "data/mastercard-pre.csv"
 #define AIRPORTNAMES "data/airportcodes.csv"
@@ -13,9 +15,9 @@
 #define AAMVAREGIONS "data/aamva-regions.csv"
 
 
-bool mod10check(char *card);
+bool mod10check(const FieldView &card);
 
-bool isMonth(char * d);
+bool isMonth(const char * d);
 
 int lastDotm(int m, int y);
 
@@ -31,17 +33,17 @@ int expandYear(int i);
 
 char * monthName(int x);
 
-char * formatter(char * format, char * n);
+char * formatter(const char * format, const FieldView &n);
 
-char * extractDate(char * format, char * n);
+char * extractDate(const char * format, const FieldView &n);
 
-char * extractName(char * format, char *n);
+char * extractName(const char * format, char *n);
 
 void reduceUpper(char * n);
 
-char * bankLookup(char * fn, char * s, int len);
+char * bankLookup(const char * fn, const FieldView &s, int len);
 
-int svIndexLookup(char *fn, char * s, int len);
+int svIndexLookup(char *fn, const char * s, int len);
 
 char * svExtract(char * fn, int j, int field, char sep);
 
@@ -18,6 +18,7 @@
 
 #include "testresult.h"
 #include <string.h>
+#include <stdio.h>
 
 TestResult::TestResult()
 {
@@ -46,7 +47,7 @@ char * TestResult::getUnknowns() const {
 	return unknowns;
 }
 
-void TestResult::addTag(char *s, char *t)
+void TestResult::addTag(const char *s, const char *t)
 {
 	//we must make sure not to add double entries
 	if(!tagExists(s)) {
@@ -60,6 +61,18 @@ void TestResult::addTag(char *s, char *t)
 	}
 }
 
+//adds a field of a track as the value
+void TestResult::addTag(const char *s, const FieldView &t)
+{
+	if(!tagExists(s)) {
+		char * a = new char[strlen(s)+1];
+		strcpy(a,s);
+		nameTags.push_back(a);
+		dataTags.push_back(t.copy());
+		valid = true;
+	}
+}
+
 void TestResult::addExtraTag(char *s) {
 	//do we already have it?
 	for(unsigned int i = 0; i < extraTags.size(); i++) {
@@ -147,7 +160,7 @@ void TestResult::setUnknowns(char *s)
 	valid = true;
 }
 
-bool TestResult::tagExists(char * s) const {
+bool TestResult::tagExists(const char * s) const {
 	for(unsigned int i = 0; i < nameTags.size(); i++) {
 		if(strcmp(s, nameTags.at(i)) == 0) {
 			return true;
@@ -27,7 +27,8 @@ public:
 	void setNotes(char *s);
 	void setUnknowns(char *s);
 
-	void addTag(char * s, char * t);
+	void addTag(const char * s, const char * t);
+	void addTag(const char * s, const FieldView &t);
 	void addExtraTag(char *s);
 
 	char * getNameTag(int i);
@@ -43,7 +44,7 @@ public:
 	bool isValid(void) const;
 
 private:
-	bool tagExists(char * n) const;
+	bool tagExists(const char * n) const;
 	
 private:
 	char * cardType;
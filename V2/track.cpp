@@ -16,10 +16,37 @@
 
 #include "track.h"
 #include "bitstream.h"
+#include "charset.h"
+#include "trackformat.h"
 #include "testfuncs.h"
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <algorithm>
+
+/* Track::Track() {
+ *
+ * An empty track, with no bits or characters. Holds a place for a track
+ * that hasn't been read
+ */
+Track::Track() {
+	number = 0;
+	decoded = false;
+	format = FORMAT_NONE;
+	verbose = true;
+	status = DECODE_OK;
+	errorPos = -1;
+	correcting = false;
+	corrections = 0;
+	correctedBit = -1;
+	slip = SLIP_NONE;
+	slipBit = -1;
+	soft = false;
+	numSoftBits = 0;
+	forcedFormat = FORMAT_NONE;
+	forcedReversed = false;
+	forcedStatus = DECODE_OK;
+}
 
 /* Track::Track(const Bytef * bs, const int &size, const int &num) {
  *
@@ -30,13 +57,50 @@
  * num - track number to associate
  */
 Track::Track(const Bytef * bs, const int &size, const int &num) {
-	bitstream = new Bitstream(bs, size);
-	bitstream->print();
+	bitstream = std::make_shared<Bitstream>(bs, size);
+	number = num;
+	decoded = false;
+	format = FORMAT_NONE;
+	verbose = true;
+	status = DECODE_OK;
+	errorPos = -1;
+	correcting = false;
+	corrections = 0;
+	correctedBit = -1;
+	slip = SLIP_NONE;
+	slipBit = -1;
+	soft = false;
+	numSoftBits = 0;
+	forcedFormat = FORMAT_NONE;
+	forcedReversed = false;
+	forcedStatus = DECODE_OK;
+}
+
+/* Track::Track(const Bitstream & bs, const int &num) {
+ *
+ * Constructor for readers that pack their bits straight into a Bitstream
+ *
+ * bs - the captured bitstream
+ * num - track number to associate
+ */
+Track::Track(const Bitstream & bs, const int &num) {
+	bitstream = std::make_shared<Bitstream>(bs);
 	number = num;
-	characters = NULL;
 	decoded = false;
-	charSet = 0;
+	format = FORMAT_NONE;
 	verbose = true;
+	status = DECODE_OK;
+	errorPos = -1;
+	correcting = false;
+	corrections = 0;
+	correctedBit = -1;
+	slip = SLIP_NONE;
+	slipBit = -1;
+	soft = false;
+	numSoftBits = 0;
+	forcedFormat = FORMAT_NONE;
+	forcedReversed = false;
+	forcedStatus = DECODE_OK;
 }
 
 /* Constructor for decoded characters. Used by readers that capture decoded
@@ -49,13 +113,23 @@ Track::Track(const Bytef * bs, const int &size, const int &num) {
  */
 Track::Track(const char * s, const int& num) {
 	//printf("Creating Track %d\n",num);
-	bitstream = NULL;
-	characters = NULL;
-	fieldBuffer = NULL;
-	charSet = NONE;
-	setChars(s);
+	decoded = false;
+	format = FORMAT_NONE;
+	status = DECODE_OK;
+	errorPos = -1;
+	correcting = false;
+	corrections = 0;
+	correctedBit = -1;
+	slip = SLIP_NONE;
+	slipBit = -1;
+	soft = false;
+	numSoftBits = 0;
+	forcedFormat = FORMAT_NONE;
+	forcedReversed = false;
+	forcedStatus = DECODE_OK;
 	number = num;
 	verbose = true;
+	setChars(s);
 
 }
 
@@ -63,10 +137,14 @@ int Track::getNumFields() const {
 	return fields.size();
 }
 
-char * Track::getField(const int &i) const {
-	if(!fields.empty())
-		return fields.at(i);
-	return NULL;
+/**
+ * @param i field number, from 0
+ * @return view of the field's characters, empty if there is no such field
+ */
+FieldView Track::getField(const int &i) const {
+	if(i < 0 || i >= (int) fields.size())
+		return FieldView();
+	return FieldView(characters.get() + fields[i].offset, fields[i].length);
 }
 
 void Track::setVerbose(const bool &v) {
@@ -77,411 +155,973 @@ int Track::getNumber() const {
 	return number;
 }
 
-char * Track::getChars() const {
-	return (characters != NULL) ? characters : (char *) "Not Decoded";
+const char * Track::getChars() const {
+	return (characters) ? characters.get() : "Not Decoded";
 }
 
 int Track::getCharSet(void) const {
-	return charSet;
+	return formatEntry(format).charSet;
+}
+
+int Track::getFormat(void) const {
+	return format;
 }
 
 bool Track::isValid() const {
 	return decoded;
 }
 
-void Track::decode() {
-	//serial readers will have already decoded
-	if(!decoded) {
-		//try all the character sets we know
-		if(!parseBCD()) {
-			//if (verbose) printf("Trying Alpha\n");
-			parseAlpha();
-		}
-	}
+/**
+ * @return DECODE_* status of the last decode, DECODE_OK if it decoded
+ */
+int Track::getStatus() const {
+	return status;
 }
 
-// private functions
-
-void Track::setChars(const char *s) {
-	if(isBCD(s))
-		setChars(s, NUMERIC);
-	else if (isAlpha(s))
-		setChars(s, ALPHANUMERIC);
+/**
+ * @return bit the failed decode stopped at, or -1
+ */
+int Track::getErrorPos() const {
+	return errorPos;
 }
 
+/**
+ * turns on repair of a single flipped bit or bit slip for the next decode
+ */
+void Track::setCorrecting(const bool &c) {
+	correcting = c;
+}
 
-void Track::setChars(const char *s, const int &i) {
-	charSet = i;
-	//printf("\"%s\" is characterset: %d\n",s,i);
-	if(characters != NULL) {
-		delete [] characters;
-		delete [] fieldBuffer;
-	}
-	characters = new char[strlen(s)+1];
-	fieldBuffer = new char[strlen(s)+1];
-	strcpy(characters, s);
-	strcpy(fieldBuffer, s);
-	decoded = true; //mark decode as valid
-	extractFields();
+/**
+ * turns on soft decision repair for the next decode. It only does
+ * anything if the track has timing margins
+ */
+void Track::setSoft(const bool &s) {
+	soft = s;
 }
 
 /**
- * @fn bool isDelim(char ch)
+ * keeps how much timing margin each bit was captured with. The lower the
+ * margin the less sure the reader was of the bit
  *
- * compares a character to a list of delimiters and
- * returns whether the character is a delimiter
- *
- * @param ch char to check
- * @return true or false on delim status
- */
-bool Track::isDelim(const char ch) const {
-	char * ptr = new char[8];
-	char * tmp = ptr; //so we can delete it later
-	memset(ptr,0,8);
-	if (charSet==ALPHANUMERIC)
-		strcpy(ptr, ALPHADELIMS);
-	else if (charSet==NUMERIC)
-		strcpy(ptr, NUMERICDELIMS);
-
-	while(*ptr) {
-		if (*ptr++ == ch) {
-			delete [] tmp;
-			return true;
-		}
-	}
-	delete [] tmp;
-	return false;
+ * @param m a margin for each bit of the bitstream, in order
+ */
+void Track::setMargins(const Bytef *m) {
+	if(!bitstream)
+		return;
+	int size = bitstream->getSize();
+	Bytef * copy = new Bytef[size];
+	memcpy(copy, m, size);
+	margins.reset(copy, std::default_delete<Bytef[]>());
 }
 
-void Track::extractFields() {
+bool Track::hasMargins() const {
+	return (bool) margins;
+}
 
-	fields.clear();
+/**
+ * keeps the times of the clock edges the bits were read on
+ */
+void Track::setEdgeTimes(const EdgeTimes &t) {
+	edgeTimes = std::make_shared<EdgeTimes>(t);
+}
 
-	char * chars = 	fieldBuffer ;
-	//move forward one character
-	chars++;
-	char * start = chars;
-	//printf("extracting\n");
-	while(*chars != 0) {
-		//printf(".");
-		if(isDelim(*chars)) {
-			//make delim a '\0', and move forward one
-			*chars++='\0';
-			//add ptr to field to array
-			//printf("adding \"%s\"\n",start);
-			fields.push_back(start);
-			//set new pointer
-			start=chars;
-		} else {
-			//go forward one
-			chars++;
-		}
+/**
+ * @return when each bit's clock edge came, or NULL if timing was off
+ */
+const EdgeTimes * Track::getEdgeTimes() const {
+	return edgeTimes.get();
+}
+
+/**
+ * @return how many bits soft decision flipped to decode the track
+ */
+int Track::getNumSoftBits() const {
+	return numSoftBits;
+}
+
+/**
+ * @param i which of them
+ * @return offset in the bitstream of a bit soft decision flipped
+ */
+int Track::getSoftBit(const int &i) const {
+	return softBits[i];
+}
+
+/**
+ * @return true if the track only decoded after a bit was repaired
+ */
+bool Track::isCorrected() const {
+	return corrections > 0;
+}
+
+int Track::getCorrections() const {
+	return corrections;
+}
+
+/**
+ * @return offset in the bitstream of the repaired bit, or -1
+ */
+int Track::getCorrectedBit() const {
+	return correctedBit;
+}
+
+/**
+ * @return SLIP_* repaired to make the track decode
+ */
+int Track::getSlip() const {
+	return slip;
+}
+
+/**
+ * @return offset in the captured bitstream of the repaired slip, or -1
+ */
+int Track::getSlipBit() const {
+	return slipBit;
+}
+
+/**
+ * @return true if the track didn't decode and a best effort read of it was
+ *	made instead
+ */
+bool Track::isForced() const {
+	return (bool) forced;
+}
+
+/**
+ * @return characters of the forced read, start sentinel first
+ */
+const char * Track::getForcedChars() const {
+	return (forced) ? forced.get() : "";
+}
+
+/**
+ * @return CONF_* of each forced character
+ */
+const char * Track::getConfidence() const {
+	return (confidence) ? confidence.get() : "";
+}
+
+int Track::getForcedFormat() const {
+	return forcedFormat;
+}
+
+bool Track::isForcedReversed() const {
+	return forcedReversed;
+}
+
+/**
+ * @return DECODE_* of the forced read, why it isn't a clean decode
+ */
+int Track::getForcedStatus() const {
+	return forcedStatus;
+}
+
+/**
+ * @return number of sentinel delimited records found by the last decode
+ */
+int Track::getNumRecords() const {
+	return records.size();
+}
+
+const TrackRecord & Track::getRecord(const int &i) const {
+	return records.at(i);
+}
+
+/**
+ * picks the candidate to use: the first one in the list that decoded,
+ * otherwise the failure that made it furthest into the stripe (earliest
+ * in the list on a tie)
+ *
+ * @return index of the chosen candidate
+ */
+static int pickCandidate(const DecodeCandidate * cands, const int &n) {
+	int best = 0;
+	for(int i = 0; i < n; i++) {
+		if(cands[i].status == DECODE_OK)
+			return i;
+		if(cands[i].pos > cands[best].pos)
+			best = i;
 	}
+	return best;
+}
+
+/**
+ * a repaired track has to account for every bit that was read, or the
+ * repair could have just made up an early end sentinel
+ *
+ * @param bits view the track decoded from
+ * @param end first bit after the LRC
+ * @return true if there are only zeros from end on
+ */
+static bool wholeTrack(const BitView &bits, const int &end) {
+	return end >= bits.getSize() || bits.firstSet(end) < 0;
 }
 
+/**
+ * decodes the bitstream, trying every format in both directions.
+ *
+ * All the candidates are evaluated against the same bits before any of
+ * them is chosen, and the choice only depends on their results, so they
+ * can be evaluated in any order (or at the same time) with the same answer.
+ */
+void Track::decode() {
+	//serial readers will have already decoded
+	if(decoded)
+		return;
+	if(verbose)
+		bitstream->print();
 
+	//BCD is Track 3 if that's where we read it, Track 2 otherwise, then
+	//Alpha, then any custom formats from the config file
+	int sets[MAXFORMATS];
+	int numSets = 0;
+	sets[numSets++] = (number == 3) ? FORMAT_TRACK3 : FORMAT_TRACK2;
+	sets[numSets++] = FORMAT_TRACK1;
+	for(int f = NUMFORMATS; f < getNumFormats(); f++)
+		sets[numSets++] = f;
 
+	DecodeCandidate cands[MAXCANDIDATES];
+	int numCands = numSets * 2;
+	//room for a bit more, in case a slip repair puts one back
+	int size = bitstream->getSize() + 1;
+	int room = 0;
+	int i;
+	for(i = 0; i < numSets; i++)
+		room += 2 * (size / formatEntry(sets[i]).bits + 1);
+	char * buffer = new char[room];
 
+	room = 0;
+	for(i = 0; i < numCands; i++) {
+		cands[i].format = sets[i / 2];
+		cands[i].reversed = (i % 2) == 1;
+		cands[i].chars = &buffer[room];
+		room += size / formatEntry(cands[i].format).bits + 1;
+		evaluate(cands[i]);
+	}
+	int best = pickCandidate(cands, numCands);
 
-//------------------------------
+	//there may be more than one record, or junk in front of the first
+	findRecords(sets, numSets);
+	int record = -1;
+	if(cands[best].status != DECODE_OK) {
+		for(i = 0; i < (int) records.size() && record < 0; i++) {
+			if(records[i].status == DECODE_OK)
+				record = i;
+		}
+	}
 
-int Track::findSSBCD() const {
-	Bytef * buffer = bitstream->getBits();
-	int size = bitstream->getSize();
-	int k;
-	for (k = 0; k < size - 4; k++) {
-		if (buffer[k] != 0) {
-			break;
+	//the bits the reader was least sure of are the likeliest to be wrong
+	if(soft && margins && cands[best].status != DECODE_OK && record < 0) {
+		for(i = 0; i < numCands; i++) {
+			if(softRepair(cands[i])) {
+				corrections++;
+				best = i;
+				break;
+			}
 		}
 	}
-	printf("first nonzero @ %d\n", k);
-	if( (buffer[k] == 1) &&
-	    (buffer[k + 1] == 1) &&
-	    (buffer[k + 2] == 0) && 
-	    (buffer[k + 3] == 1) && 
-	    (buffer[k + 4] == 0)) {
-		if (verbose) printf("Start char located at: %d\n", k);
-		return k;
+
+	//nothing decoded, see if a flipped bit or a bit slip explains it
+	if(correcting && cands[best].status != DECODE_OK && record < 0) {
+		char * spare = new char[size + 1];	//a char a bit is always enough
+		for(i = 0; i < numCands; i++) {
+			if(repair(cands[i], spare)) {
+				corrections++;
+				best = i;
+				break;
+			}
+		}
+		delete [] spare;
 	}
+
 	if(verbose) {
-		if (k == size -4) {
-			printf("Start char not found\n");
-		} else {
-			printf("Start char not first character\n");
+		for(i = 0; i < numCands; i++) {
+			printf("%s %s: %s at bit %d\n",
+			       formatEntry(cands[i].format).name,
+			       (cands[i].reversed) ? "backwards" : "forwards",
+			       statusString(cands[i].status), cands[i].pos);
 		}
 	}
-	return -1;
+	if(record >= 0) {
+		status = DECODE_OK;
+		errorPos = -1;
+		if(verbose)
+			printf("Using the record at bit %d\n", records[record].offset);
+		setChars(records[record].chars, records[record].format);
+		delete [] buffer;
+		return;
+	}
+	status = cands[best].status;
+	if(status == DECODE_OK) {
+		errorPos = -1;
+		if(verbose && cands[best].reversed)
+			printf("Card was swiped backwards\n");
+		if(verbose && correctedBit >= 0)
+			printf("Corrected bit %d\n", correctedBit);
+		if(verbose && slip == SLIP_DROPPED)
+			printf("Put back a dropped bit at bit %d\n", slipBit);
+		if(verbose && slip == SLIP_EXTRA)
+			printf("Took out an extra bit at bit %d\n", slipBit);
+		for(i = 0; verbose && i < numSoftBits; i++)
+			printf("Soft decision flipped bit %d\n", softBits[i]);
+		setChars(cands[best].chars, cands[best].format);
+	} else {
+		errorPos = cands[best].pos;
+		if(verbose)
+			printf("Not a valid Character set\n");
+		forceBest(cands, numCands, size);
+	}
+	delete [] buffer;
 }
 
-int Track::findESBCD(const int &ss) const {
-	Bytef * buffer = bitstream->getBits();
-	int size = bitstream->getSize();
-	int k;
-	int p=1;
-	for (k = ss; k < size -4; k+=5) 	{
-		printf("Char %d: \"%d%d%d%d%d\"\n", p, buffer[k], buffer[k+1], buffer[k+2], buffer[k+3], buffer[k+4]);
-
-		if ((buffer[k] == 1) &&
-		   (buffer[k + 1] == 1) &&
-		   (buffer[k + 2] == 1) &&
-		   (buffer[k + 3] == 1) &&
-		   (buffer[k + 4] == 1)) {
-			break;
+/**
+ * forces every candidate and keeps the read with the most characters that
+ * pass parity. Ties go to the earlier candidate, the ISO format for the
+ * track forwards first
+ *
+ * @param cands candidates that all failed. Their chars are overwritten
+ * @param numCands how many
+ * @param size bits, for the size of the buffers
+ */
+void Track::forceBest(DecodeCandidate * cands, const int &numCands,
+		      const int &size) {
+	char * conf = new char[size + 1];
+	int best = -1;
+	int most = -1;
+	int st;
+	for(int i = 0; i < numCands; i++) {
+		int good = force(cands[i], cands[i].chars, conf, st);
+		if(good > most) {
+			most = good;
+			best = i;
 		}
-	p++;
 	}
-	if(k >= size -4) 	{
-		if (verbose) printf("End Char not found\n");
+	delete [] conf;
+	if(most < 0)
+		return;	//no start sentinel anywhere
+
+	const DecodeCandidate &c = cands[best];
+	char * chars = new char[size + 1];
+	conf = new char[size + 1];
+	force(c, chars, conf, forcedStatus);
+	forced.reset(chars, std::default_delete<char[]>());
+	confidence.reset(conf, std::default_delete<char[]>());
+	forcedFormat = c.format;
+	forcedReversed = c.reversed;
+	if(verbose)
+		printf("Forced %s %s: %d of %d characters passed parity\n",
+		       formatEntry(c.format).name,
+		       (c.reversed) ? "backwards" : "forwards",
+		       most, (int) strlen(chars));
+}
+
+/**
+ * best effort read of a candidate that failed, like the force parse of
+ * Stripe Snoop 1. It starts at the first start sentinel anywhere in the
+ * bits instead of only at the first 1 bit, and reads characters whatever
+ * their parity until the end sentinel or the last 1 bit. Then the LRC is
+ * checked if there is one.
+ *
+ * @param c candidate, for its format and direction
+ * @param out buffer of at least size / bits + 1 chars
+ * @param conf buffer as big as out, gets the CONF_* of each character
+ * @param st set to DECODE_PARITY if a character failed, otherwise to how
+ *	the read ended
+ * @return characters that passed parity, -1 if there's no start sentinel
+ */
+int Track::force(const DecodeCandidate &c, char * out, char * conf,
+		 int &st) const {
+	const FormatEntry &f = formatEntry(c.format);
+	const int bpc = f.bits;
+	const int pb = f.parityBits;
+	BitView bits(*bitstream, c.reversed);
+	int size = bits.getSize();
+	int end = bits.lastSet(size - 1) + 1;
+	int pos = bits.firstSet(0);
+	int len = 0;
+	int good = 0;
+	Wordf lrc = 0;
+	Wordf code = 0;
+
+	out[0] = '\0';
+	if(pos < 0)
+		return -1;
+	while(pos + bpc <= size && bits.getBits(pos, bpc) != f.ss)
+		pos++;
+	if(pos + bpc > size)
 		return -1;
+	while(pos < end && pos + bpc <= size) {
+		code = bits.getBits(pos, bpc);
+		lrc ^= code >> pb;
+		out[len] = f.table[code].ch;
+		conf[len++] = (f.table[code].parity) ? CONF_GOOD : CONF_PARITY;
+		pos += bpc;
+		if(code == f.es)
+			break;
+	}
+	out[len] = '\0';
+	for(int i = 0; i < len; i++)
+		good += (conf[i] == CONF_GOOD);
+
+	if(good < len)
+		st = DECODE_PARITY;
+	else if(code != f.es)
+		st = DECODE_NOES;
+	else if(pos + bpc > size)
+		st = DECODE_NOLRC;
+	else {
+		Wordf expect = lrc;
+		if(pb != 0)
+			expect = (lrc << 1) | (f.table[lrc << 1].parity ? 0 : 1);
+		st = (bits.getBits(pos, bpc) == expect) ? DECODE_OK : DECODE_LRC;
 	}
-	if(verbose) printf("End Char located at: %d\n", k);
-	return k;
+	return good;
+}
+
+/**
+ * orders records by where they start in the bitstream
+ */
+static bool recordBefore(const TrackRecord &a, const TrackRecord &b) {
+	int x = (a.reversed) ? a.offset - a.length + 1 : a.offset;
+	int y = (b.reversed) ? b.offset - b.length + 1 : b.offset;
+	return x < y;
 }
 
-bool Track::errorCheckBCD(const int &start, const int &end) const {
-	
-	Bytef * buffer = bitstream->getBits();
+/**
+ * finds every sentinel delimited record on the track, in any of the
+ * formats and either direction, not just one at the first 1 bit.
+ *
+ * One pass over the bitstream finds every start sentinel of every format,
+ * forwards and mirrored for backwards. Then for each format and direction
+ * a record is tried at each start sentinel in turn. An attempt stops at a
+ * parity failure or at the next start sentinel in the same alignment, so
+ * no bit is read twice per alignment and the whole thing stays linear in
+ * the length of the track. Records that overlap are settled in favor of
+ * the one that passed its LRC, then the longer one.
+ *
+ * @param sets formats to look for
+ * @param numSets how many
+ */
+void Track::findRecords(const int * sets, const int &numSets) {
+	records.clear();
 	int size = bitstream->getSize();
-	//Phase 1----------Are our inputs even valid?
-	if(start < 0 || end < 0 || start > end) {
-		return false;
+	int room = 0;
+	int i;
+	for(i = 0; i < numSets; i++)
+		room += 4 * (size / formatEntry(sets[i]).bits + 1);
+	char * buffer = new char[room];
+	recordBuffer.reset(buffer, std::default_delete<char[]>());
+
+	//every start sentinel, forwards then mirrored
+	BitPattern pats[MAXCANDIDATES];
+	offsetVec hits[MAXCANDIDATES];
+	for(i = 0; i < numSets; i++) {
+		const FormatEntry &f = formatEntry(sets[i]);
+		pats[2 * i].code = f.ss;
+		pats[2 * i].length = f.bits;
+		pats[2 * i + 1].code = mirrorWord(f.ss) >> (WORDBITS - f.bits);
+		pats[2 * i + 1].length = f.bits;
 	}
-	
-	//Phase 2---------Does it pass its LRC?
-	char lrc[5];
-	int i, j;
-
-	memset(lrc,0,5);
-	//Just XOR the Data Bits of each character, not the parity bit*/
-	for(i=start;i<=end;i+=5)
-		for(j=0;j<4;j++)
-    			lrc[j] = lrc[j] ^ buffer[i+j];
-	//Calculate LRC Odd Parity bit
-	i = 0;
-	for(j = 0; j<4;j++)
-		if(lrc[j]==1)
-			i++;
-	if( (i % 2) == 0) lrc[4]=1;
-	//valid LRC?
-	if(end+5 <=(size - 5) && strncmp(lrc,(char *)&buffer[end+5],5)!=0)
-			return false;
-
-	//Phase 3----------Parity Checks
-//	for(i=start;i<=end;i+=5) {
-//		if(!parityCheck(&buffer[i], ODD, 5)) {
-//		if (verbose) printf("Parity Check Failed at %d\n",i);
-//			return false;
-//		}
-//	}
-	return true;
+	bitstream->findPatterns(pats, numSets * 2, hits);
 
+	recordVec found;
+	room = 0;
+	for(i = 0; i < numSets * 2; i++) {
+		const FormatEntry &f = formatEntry(sets[i / 2]);
+		bool reversed = (i % 2) == 1;
+		BitView bits(*bitstream, reversed);
+		int n = hits[i].size();
+		int done[8] = { 0 };	//per alignment, bits already read
+		int next = 0;		//bits before this are in a record
+		for(int k = 0; k < n; k++) {
+			//hits are in bitstream order, so backwards go from the end
+			int h = (reversed) ? size - hits[i][n - 1 - k] - f.bits
+					   : hits[i][k];
+			int pos;
+			if(h < next || h < done[h % f.bits])
+				continue;
+			int status = f.scanRecord(f, bits, h, &buffer[room], pos);
+			if(status == DECODE_PARITY || status == DECODE_NOES) {
+				done[h % f.bits] = pos;
+				continue;
+			}
+			TrackRecord r;
+			r.offset = (reversed) ? size - 1 - h : h;
+			r.length = pos - h;
+			r.format = sets[i / 2];
+			r.reversed = reversed;
+			r.status = status;
+			r.chars = &buffer[room];
+			found.push_back(r);
+			room += strlen(r.chars) + 1;
+			next = pos;
+		}
+	}
+
+	std::sort(found.begin(), found.end(), recordBefore);
+	for(i = 0; i < (int) found.size(); i++) {
+		const TrackRecord &r = found[i];
+		if(!records.empty()) {
+			TrackRecord &last = records.back();
+			int end = (last.reversed) ? last.offset + 1
+						  : last.offset + last.length;
+			int start = (r.reversed) ? r.offset - r.length + 1 : r.offset;
+			if(start < end) {
+				//overlap, keep the better one
+				bool good = (r.status == DECODE_OK);
+				bool lastGood = (last.status == DECODE_OK);
+				if(good > lastGood ||
+				   (good == lastGood && r.length > last.length))
+					last = r;
+				continue;
+			}
+		}
+		records.push_back(r);
+	}
 }
 
+/**
+ * decodes the track one way, filling in the candidate's results. Only
+ * reads the bitstream, so candidates can be evaluated concurrently
+ *
+ * @param c candidate with format, reversed and chars set
+ */
+void Track::evaluate(DecodeCandidate &c) const {
+	BitView bits(*bitstream, c.reversed);
+	const FormatEntry &f = formatEntry(c.format);
+	c.status = f.scan(f, bits, c.chars, c.pos);
+}
 
-int Track::findSSAlpha() const{
-	Bytef * buffer = bitstream->getBits();
+/**
+ * tries to repair a candidate that failed on a single flipped bit.
+ *
+ * A flipped bit always breaks the parity of its character, and it also
+ * breaks the LRC in that bit's column. So the bad bit has to be in the
+ * character the scan stopped at (the first to fail parity, the LRC, or a
+ * start sentinel that wasn't recognised), and only flipping the right one
+ * of its bits passes both the parity of every character and the LRC. Each
+ * of those bits is flipped in a copy of the bitstream and rescanned, and
+ * the repair is only accepted if exactly one of them decodes, without
+ * leaving anything after the LRC. Formats
+ * without parity can't tell where the bad character is, so they are not
+ * corrected.
+ *
+ * @param c candidate that has been evaluated. On success its results are
+ *	replaced with the corrected decode
+ * @return offset in the bitstream of the bit to flip, or -1
+ */
+int Track::correct(DecodeCandidate &c) const {
+	const FormatEntry &f = formatEntry(c.format);
 	int size = bitstream->getSize();
-	int k;
+	//bits to try flipping
+	int from = c.pos;
+	int to = c.pos + f.bits;
+	if(c.status == DECODE_NOSS) {
+		//the start sentinel, or a stray 1 bit in front of it
+		if(c.pos >= size)
+			return -1;
+		from = c.pos - f.bits + 1;
+	} else if(c.status != DECODE_PARITY && c.status != DECODE_LRC) {
+		return -1;
+	}
+	if(f.custom != NULL && f.custom->parityBits() == 0)
+		return -1;
 
-	for (k = 0;k < size - 6; k++) 	{
-		if (buffer[k] !=0) {
-			break;
+	Bitstream trial(*bitstream);
+	BitView bits(trial, c.reversed);
+	int found = 0;
+	int fixed = -1;
+	int pos;
+	for(int j = (from < 0) ? 0 : from; j < to && j < size; j++) {
+		int b = (c.reversed) ? size - 1 - j : j;
+		trial.setBit(b, !trial.getBit(b));
+		if(f.scan(f, bits, c.chars, pos) == DECODE_OK &&
+		   wholeTrack(bits, pos + f.bits)) {
+			found++;
+			fixed = b;
 		}
+		trial.setBit(b, !trial.getBit(b));
 	}
-	printf("First Nonzero @ %d\n",k);
-	if( (buffer[k] == 1) &&
-	    (buffer[k + 1] == 0) && 
-	    (buffer[k + 2] == 1) &&
-	    (buffer[k + 3] == 0) &&
-	    (buffer[k + 4] == 0) &&
-	    (buffer[k + 5] == 0) &&
-	    (buffer[k + 6] == 1)) {
-		if (verbose) printf("Start char located at: %d\n", k);
-		return k;
-	}
-	if(verbose) {
-		if (k == size - 6) {
-			printf("Start char not found\n");
-		} else {
-			printf("Start char not first character\n");
-		}
+	if(found != 1) {
+		evaluate(c);	//put the failed results back
+		return -1;
 	}
-	return -1;
+	trial.setBit(fixed, !trial.getBit(fixed));
+	c.status = f.scan(f, bits, c.chars, c.pos);
+	return fixed;
 }
 
-int Track::findESAlpha(const int &ss) const {
-	Bytef * buffer = bitstream->getBits();
+/**
+ * tries to repair a candidate that failed because the reader missed a
+ * clock edge, or counted one twice, part way through the swipe.
+ *
+ * Every character after the slip is misaligned by a bit, so the scan
+ * fails parity soon after it. Working back from that character, a bit is
+ * taken out (or a 0 or a 1 put back) at each offset, looking for the ones
+ * after which parity realigns all the way to the end sentinel and the LRC
+ * matches, with nothing left after the LRC. A few misaligned characters can pass parity by chance, and
+ * pairs of them cancel out in the LRC, so every offset back to the start
+ * sentinel is tried, and the repair is only used if all the ones that
+ * decode give the same characters. The nearest to the failure is reported.
+ *
+ * @param c candidate that has been evaluated. On success its results are
+ *	replaced with the repaired decode
+ * @param out set to the repaired bitstream
+ * @param at set to the offset in the captured bitstream of the slip
+ * @return SLIP_* that was repaired, SLIP_NONE if it couldn't be
+ */
+int Track::resync(DecodeCandidate &c, Bitstream &out, int &at) const {
+	const FormatEntry &f = formatEntry(c.format);
+	if(c.status != DECODE_PARITY)
+		return SLIP_NONE;
+	if(f.custom != NULL && f.custom->parityBits() == 0)
+		return SLIP_NONE;
+
 	int size = bitstream->getSize();
-	int k;
-	for(k = ss;k <  size - 6; k += 7) {
-		if ((buffer[k] == 1) &&
-		    (buffer[k + 1] == 1) && 
-		    (buffer[k + 2] == 1) && 
-		    (buffer[k + 3] == 1) && 
-		    (buffer[k + 4] == 1) && 
-		    (buffer[k + 5] == 0) && 
-		    (buffer[k + 6] == 0)) {
-			break;
+	char * chars = new char[(size + 1) / f.bits + 1];
+	Bitstream trial(*bitstream);
+	int found = SLIP_NONE;
+	int pos;
+	//the start sentinel was fine, so the slip is after it
+	int first = BitView(*bitstream, c.reversed).firstSet(0) + f.bits;
+	for(int p = c.pos + f.bits - 1; p >= first; p--) {
+		for(int kind = 0; kind < 3; kind++) {
+			trial = *bitstream;
+			int b;
+			if(kind == 0) {
+				b = (c.reversed) ? size - 1 - p : p;
+				trial.removeBit(b);
+			} else {
+				b = (c.reversed) ? size - p : p;
+				trial.insertBit(b, kind - 1);
+			}
+			BitView bits(trial, c.reversed);
+			if(f.scan(f, bits, chars, pos) != DECODE_OK ||
+			   !wholeTrack(bits, pos + f.bits))
+				continue;
+			if(found == SLIP_NONE) {
+				found = (kind == 0) ? SLIP_EXTRA : SLIP_DROPPED;
+				at = b;
+				out = trial;
+				strcpy(c.chars, chars);
+				c.pos = pos;
+			} else if(strcmp(c.chars, chars) != 0) {
+				found = SLIP_NONE;	//can't tell which is right
+				p = 0;
+				break;
+			}
 		}
 	}
-	
-	if(k >= size - 6) {
-		if (verbose) printf("End Char not found\n");
-		return -1;
+	delete [] chars;
+	if(found == SLIP_NONE) {
+		at = -1;
+		evaluate(c);	//put the failed results back
+	} else {
+		c.status = DECODE_OK;
 	}
-	if(verbose) printf("End Char located at: %d\n", k);
-	return k;
+	return found;
 }
 
-bool Track::errorCheckAlpha(const int &start, const int &end) const {
+/**
+ * one or two bits soft decision tries flipping
+ */
+class SoftTry {
+public:
+	int cost;	//margins added up, single bits before pairs
+	int a;		//offsets in the bitstream, b == a for a single bit
+	int b;
+	bool operator<(const SoftTry &t) const {
+		return cost < t.cost;
+	}
+};
 
-	//Phase 1----------Are our inputs even valid?
-	if(start <0 || end <0 ||start >= end)
-		return false;
+/**
+ * orders bits by timing margin, then by position
+ */
+class MarginLess {
+public:
+	const Bytef * m;
+	bool operator()(const int &a, const int &b) const {
+		return (m[a] != m[b]) ? m[a] < m[b] : a < b;
+	}
+};
 
-	Bytef * buffer = bitstream->getBits();
+/**
+ * soft decision repair of a candidate that failed. The bits the reader
+ * captured with the least timing margin are the likeliest to be wrong, so
+ * the SOFTBITS least confident bits of the track are flipped one at a time,
+ * then two at a time, least confident first. The first flip after which
+ * every character passes parity, the LRC matches and nothing is left after
+ * it is used. Unlike correct(), two bits in one character (which parity
+ * can't see) or in different characters can be repaired.
+ *
+ * @param c candidate that has been evaluated. On success its results are
+ *	replaced with the repaired decode
+ * @param flipped set to the offsets in the bitstream of the bits to flip
+ * @return how many bits to flip, 0 if nothing worked
+ */
+int Track::softCorrect(DecodeCandidate &c, int * flipped) const {
+	const FormatEntry &f = formatEntry(c.format);
+	if(f.parityBits == 0)
+		return 0;
 	int size = bitstream->getSize();
+	const Bytef * m = margins.get();
+
+	//the track, with room for a flipped bit either side of it
+	int first = bitstream->firstSet(0);
+	if(first < 0)
+		return 0;
+	int last = bitstream->lastSet(size - 1);
+	int from = first - f.bits;
+	int to = last + 2 * f.bits;
+	if(from < 0)
+		from = 0;
+	if(to > size)
+		to = size;
+
+	std::vector<int> order;
+	for(int i = from; i < to; i++)
+		order.push_back(i);
+	int n = (to - from < SOFTBITS) ? to - from : SOFTBITS;
+	MarginLess less;
+	less.m = m;
+	std::partial_sort(order.begin(), order.begin() + n, order.end(), less);
 
-	//Phase 2---------Does it pass its LRC?
-	char lrc[7];
-	int i, j;
-	
-	memset(lrc,0,7);
-	//Just XOR the Data Bits of each character, not the parity bit*/
-	for(i=start;i<=end;i+=7)
-		for(j=5;j>-1;j--)
-    		lrc[j] = lrc[j] ^ buffer[i+j];
-	//Calculate LRC Odd Parity bit
-	i = 0;
-	for(j = 0; j<6;j++)
-		    if(lrc[j]==1)
-			i++;
-	if( (i % 2) == 0) lrc[6]=1;
-	//valid LRC?
-	if(end+7 <=(size -7) && strncmp(lrc, (char *)&buffer[end+7],7)!=0)
-			return false;
-
-	//Phase 3----------Parity Checks
-	for(i=start;i<=end;i+=7) {
-		if(!parityCheck(&buffer[i], ODD, 7)) {
-		if (verbose) printf("Parity Check Failed at %d\n",i);
-			return false;
+	//pairs by how unsure of both bits the reader was
+	std::vector<SoftTry> tries;
+	SoftTry t;
+	for(int i = 0; i < n; i++) {
+		for(int j = i; j < n; j++) {
+			t.a = order[i];
+			t.b = order[j];
+			//a margin is at most 255, so every pair costs more
+			t.cost = (j == i) ? m[t.a] : 256 + m[t.a] + m[t.b];
+			tries.push_back(t);
 		}
 	}
-	return true;
-}
+	std::stable_sort(tries.begin(), tries.end());
 
+	Bitstream trial(*bitstream);
+	BitView bits(trial, c.reversed);
+	int pos;
+	for(int k = 0; k < (int) tries.size(); k++) {
+		int a = tries[k].a;
+		int b = tries[k].b;
+		trial.setBit(a, !trial.getBit(a));
+		if(b != a)
+			trial.setBit(b, !trial.getBit(b));
+		if(f.scan(f, bits, c.chars, pos) == DECODE_OK &&
+		   wholeTrack(bits, pos + f.bits)) {
+			c.status = DECODE_OK;
+			c.pos = pos;
+			flipped[0] = a;
+			flipped[1] = b;
+			return (b != a) ? 2 : 1;
+		}
+		trial.setBit(a, !trial.getBit(a));
+		if(b != a)
+			trial.setBit(b, !trial.getBit(b));
+	}
+	evaluate(c);	//put the failed results back
+	return 0;
+}
 
-bool Track::parityCheck(const Bytef *bs, const int &type,
-			const int &bpc) const {
-	int i,j=0;
-	for(i=0;i<bpc-1;i++)
-		if(bs[i]==1) j++;
-	if((j % 2) ==0 && bs[bpc-1]!=type)
+/**
+ * soft decision repair of a candidate, keeping the repaired bits
+ *
+ * @return true if the track was repaired
+ */
+bool Track::softRepair(DecodeCandidate &c) {
+	int flipped[SOFTFLIPS];
+	int n = softCorrect(c, flipped);
+	if(n == 0)
 		return false;
+	Bitstream * fixed = new Bitstream(*bitstream);
+	for(int i = 0; i < n; i++) {
+		fixed->setBit(flipped[i], !fixed->getBit(flipped[i]));
+		softBits[i] = flipped[i];
+	}
+	bitstream.reset(fixed);
+	numSoftBits = n;
 	return true;
 }
 
-bool Track::parseBCD() {
-	
-	int start = findSSBCD();
-	int end = findESBCD(start);
-	/* is bitstream valid? */
-	if(!errorCheckBCD(start, end)) {
-		if (verbose) printf("BCD Error checking fails, Trying to parse backwards\n");
-        	// try backwards
-		bitstream->reverse();
-		//bitstream->print();
-		start = findSSBCD();
-		end = findESBCD(start);
-		if(!errorCheckBCD(start, end)) {
-			//flip it back
-			bitstream->reverse();
-			printf("BCD Error checking failed in both directions\n");
-			printf("Not a valid BCD Character set\n");
-			return false;
-		}
+/**
+ * tries both kinds of repair on a candidate that failed. If a flipped bit
+ * and a slip both explain it they have to agree on the characters, or
+ * there's no telling which happened and neither is used.
+ *
+ * @param c candidate that has been evaluated. On success its results are
+ *	replaced with the repaired decode and the track gets a repaired
+ *	copy of the bitstream. Copies of the track keep the bits they had
+ * @param spare buffer as big as the candidate's chars
+ * @return true if the track was repaired
+ */
+bool Track::repair(DecodeCandidate &c, char * spare) {
+	DecodeCandidate s = c;
+	s.chars = spare;
+	Bitstream * fixed = new Bitstream(*bitstream);
+	int at;
+	int bit = correct(c);
+	int kind = resync(s, *fixed, at);
+	if(bit >= 0 && kind != SLIP_NONE && strcmp(c.chars, s.chars) != 0) {
+		delete fixed;
+		evaluate(c);
+		return false;
 	}
-	//we are good, so decode it
-	decodeBCD(start, end);
-	return true;
+	if(bit >= 0) {
+		*fixed = *bitstream;
+		fixed->setBit(bit, !fixed->getBit(bit));
+		bitstream.reset(fixed);
+		correctedBit = bit;
+		return true;
+	}
+	if(kind != SLIP_NONE) {
+		bitstream.reset(fixed);
+		strcpy(c.chars, s.chars);
+		c.status = s.status;
+		c.pos = s.pos;
+		slip = kind;
+		slipBit = at;
+		return true;
+	}
+	delete fixed;
+	return false;
 }
 
-bool Track::parseAlpha() {
-	
-	int start = findSSAlpha();
-	int end = findESAlpha(start);
-	/* is bitstream valid? */
-	if(!errorCheckAlpha(start, end)) {
-		if (verbose) printf("Alpha Error checking fails, Trying to parse backwards\n");
-        	/* try backwards */
-		bitstream->reverse();
-		start = findSSAlpha();
-		end = findESAlpha(start);
-		if(!errorCheckAlpha(start, end)) {
-			printf("Alpha Error checking failed in both directions\n");
-			printf("Not a valid Alpha Character set\n");
-			return false;
-		}
-	}
-	//we are good, so decode it
-	decodeAlpha(start, end);
-	return true;
+// private functions
+
+void Track::setChars(const char *s) {
+	if(isBCD(s))
+		setChars(s, (number == 3) ? FORMAT_TRACK3 : FORMAT_TRACK2);
+	else if (isAlpha(s))
+		setChars(s, FORMAT_TRACK1);
 }
 
 
-void Track::decodeBCD(const int &start,const int &end)
-{
-	char * tempDecode = new char[41]; //can't have more than 40 characters
-	memset(tempDecode,0,41);
-	Bytef * buffer = bitstream->getBits(); //get the bitstream
-	char *ptrNext;
-	char BCD[17]; //will hold the character set string
+void Track::setChars(const char *s, const int &f) {
+	format = f;
+	//printf("\"%s\" is characterset: %d\n",s,i);
+	char * chars = new char[strlen(s)+1];
+	strcpy(chars, s);
+	characters.reset(chars, std::default_delete<char[]>());
+	decoded = true; //mark decode as valid
+	extractFields();
+}
 
-	strcpy(BCD, "084<2:6>195=3;7?");
-	ptrNext = tempDecode;
+/**
+ * indexes the fields of the decoded characters in one pass. A field is
+ * everything after the start sentinel or a delimiter, up to the next
+ * delimiter. The characters themselves are left alone
+ */
+void Track::extractFields() {
+	FieldSpan f;
 
-	for(int i = start; i <= end; i += 5 ) {
-		int k = 0;
-		for(int j = 0; j < 4; j++) {
-			k = k * 2 + buffer[i + j];
-		}
-		if(k>=0 && k<=15) {
-			*ptrNext++=BCD[k];
-		} else {
-			*ptrNext++='X'; //if we have an undefined character
-		}
-	}
-	//set new decoded characters
-	setChars(tempDecode, NUMERIC);
-	delete [] tempDecode;
-}
-
-
-void Track::decodeAlpha(const int &start,const int &end)
-{
-	char * tempDecode = new char[80]; //can't have more than 79 characters
-	memset(tempDecode,0,80);
-	Bytef * buffer = bitstream->getBits(); //get the bitstream
-	char *ptrNext;
-	char alpha[65]; //will hold the character set string
-
-	strcpy(alpha, " !\"#$%&\'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_");
-	ptrNext = tempDecode;
-
-	for(int i = start; i <= end; i += 7 ) {
-		int k = 0;
-		for(int j=5;j>-1;j--)
-			k=k*2+buffer[i+j];
-		if(k>=0 && k<=63) {
-			*ptrNext++=alpha[k];
-		} else {
-			*ptrNext++='X'; //if we have an undefined character
+	fields.clear();
+	//skip the start sentinel
+	f.offset = 1;
+	const char * chars = characters.get();
+	for(int i = 1; chars[i] != 0; i++) {
+		if(isFormatDelim(format, chars[i])) {
+			f.length = i - f.offset;
+			fields.push_back(f);
+			f.offset = i + 1;
 		}
 	}
-	//set new decoded characters
-	setChars(tempDecode, ALPHANUMERIC);
-	delete [] tempDecode;
 }
 
+//------------------------------------------------------------------ FieldView
+
+FieldView::FieldView() {
+	chars = "";
+	length = 0;
+}
 
+FieldView::FieldView(const char *s, const int &len) {
+	chars = s;
+	length = len;
+}
+
+char FieldView::operator[](const int &i) const {
+	if(i < 0 || i >= length)
+		return 0;
+	return chars[i];
+}
+
+/**
+ * @return true if the field is exactly s
+ */
+bool FieldView::equals(const char *s) const {
+	return (int) strlen(s) == length && matches(0, s);
+}
+
+bool FieldView::startsWith(const char *s) const {
+	return matches(0, s);
+}
+
+/**
+ * @param at character of the field to compare from
+ * @param s characters expected there
+ * @return true if the field has all of s at that position
+ */
+bool FieldView::matches(const int &at, const char *s) const {
+	int n = strlen(s);
+	if(at < 0 || at + n > length)
+		return false;
+	return strncmp(&chars[at], s, n) == 0;
+}
+
+/**
+ * @return the field without its first i characters
+ */
+FieldView FieldView::from(const int &i) const {
+	return sub(i, length);
+}
+
+/**
+ * @param at first character
+ * @param len most characters to include
+ * @return that part of the field, clipped to it
+ */
+FieldView FieldView::sub(const int &at, const int &len) const {
+	int n = (at < length) ? at : length;
+	int l = (len < length - n) ? len : length - n;
+	return FieldView(&chars[n], l);
+}
+
+/**
+ * @return NUL terminated copy of the field, the caller deletes it
+ */
+char * FieldView::copy() const {
+	char * s = new char[length + 1];
+	memcpy(s, chars, length);
+	s[length] = 0;
+	return s;
+}
+
+//------------------------------
+
+/**
+ * gives a printable reason for a decode status
+ *
+ * @param s DECODE_* status
+ * @return constant string describing it
+ */
+const char * Track::statusString(const int &s) {
+	switch(s) {
+		case DECODE_OK:
+			return "OK";
+		case DECODE_NOSS:
+			return "start char not first character";
+		case DECODE_NOES:
+			return "end char not found";
+		case DECODE_PARITY:
+			return "parity check failed";
+		case DECODE_NOLRC:
+			return "no LRC after end char";
+		case DECODE_LRC:
+			return "LRC check failed";
+	}
+	return "unknown";
+}
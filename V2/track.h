@@ -8,74 +8,177 @@
 #define TRACK_H
 
 #include "bitstream.h"
+#include "charset.h"
+#include "trackformat.h"
+#include "edgetimes.h"
 #include <vector>
+#include <memory>
 
-typedef std::vector<char *>  stringVec;
+//a field of the decoded characters, delimiter not included
+class FieldSpan {
+public:
+	int offset;	//first character
+	int length;	//characters
+};
 
-//-----------------------Defines
-//used for character sets
-#define NONE 0
-#define ALPHANUMERIC 1
-#define NUMERIC 2
-//parity defines
-#define ODD 1
-#define EVEN 0
+typedef std::vector<FieldSpan>  spanVec;
 
-#define ALPHADELIMS "%^?"
-#define NUMERICDELIMS ":<>=?"
+//a field as handed out by a track. Points into the track's characters, so it
+//is not NUL terminated and is only good while the track is
+class FieldView {
+public:
+	const char * chars;	//first character
+	int length;
+
+	FieldView();
+	FieldView(const char *, const int&);
+	char operator[](const int&) const; //0 past the end, like a string
+	bool equals(const char *) const;
+	bool startsWith(const char *) const;
+	bool matches(const int&, const char *) const;
+	FieldView from(const int&) const;
+	FieldView sub(const int&, const int&) const;
+	char * copy(void) const;
+};
 
+//one way of reading a track, a format in one direction
+class DecodeCandidate {
+public:
+	int format;	//FORMAT_*
+	bool reversed;	//read the bits backwards
+	int status;	//DECODE_*
+	int pos;	//bit the decode stopped at
+	char * chars;	//decoded characters, may be partial
+};
 
+#define MAXCANDIDATES (MAXFORMATS * 2)	//every format, forwards and backwards
 
+//one sentinel delimited record found on a track
+class TrackRecord {
+public:
+	int offset;	//bit of the bitstream the start sentinel is read from first
+	int length;	//bits, start sentinel through LRC
+	int format;	//FORMAT_*
+	bool reversed;	//recorded backwards
+	int status;	//DECODE_OK, DECODE_LRC or DECODE_NOLRC
+	const char * chars;	//start sentinel through end sentinel
+};
+
+typedef std::vector<TrackRecord>  recordVec;
+
+//bit slip repairs
+#define SLIP_NONE 0
+#define SLIP_DROPPED 1	//a clock edge was missed, a bit was put back
+#define SLIP_EXTRA 2	//a clock edge was counted twice, a bit was taken out
+
+//soft decision repair
+#define SOFTBITS 12	//least confident bits it tries
+#define SOFTFLIPS 2	//most of them it flips at once
+
+//confidence in a character of a forced decode
+#define CONF_GOOD 0	//passed parity
+#define CONF_PARITY 1	//failed parity, the character is a guess
+
+
+//Copies of a track share its bits and characters. Neither is changed once
+//set, only replaced, so tracks copy and move cheaply and a copy never sees
+//another change.
 class Track {
 public:
+	Track();
 	Track(const Bytef *,const int&, const int&);	
+	Track(const Bitstream &, const int&);
 	Track(const char *, const int&);
 	void decode(void);
-	char * getChars(void) const; //return decoded characters (if any)
+	const char * getChars(void) const; //return decoded characters (if any)
 	int getNumber(void) const; //returns track number
 	bool isValid(void) const;
 	void setVerbose(const bool&);
 	int getNumFields(void) const;
-	char * getField(const int&) const;
+	FieldView getField(const int&) const;
 	int getCharSet(void) const;
+	int getFormat(void) const;
+	int getStatus(void) const;
+	int getErrorPos(void) const;
+	void setCorrecting(const bool&);
+	void setSoft(const bool&);
+	void setMargins(const Bytef *);
+	bool hasMargins(void) const;
+	void setEdgeTimes(const EdgeTimes &);
+	const EdgeTimes * getEdgeTimes(void) const;
+	int getNumSoftBits(void) const;
+	int getSoftBit(const int&) const;
+	bool isCorrected(void) const;
+	int getCorrections(void) const;
+	int getCorrectedBit(void) const;
+	int getSlip(void) const;
+	int getSlipBit(void) const;
+	bool isForced(void) const;
+	const char * getForcedChars(void) const;
+	const char * getConfidence(void) const;
+	int getForcedFormat(void) const;
+	bool isForcedReversed(void) const;
+	int getForcedStatus(void) const;
+	int getNumRecords(void) const;
+	const TrackRecord & getRecord(const int&) const;
+	static const char * statusString(const int&);
 
 private:
 	
-	Bitstream * bitstream;
-	char * characters;
+	std::shared_ptr<const Bitstream> bitstream;
+	std::shared_ptr<const char> characters;
 	bool decoded;
-	int charSet;	//use defines
+	int format;	//FORMAT_*
 	int number;
 	bool verbose;
 	//bool
 	
 	//field stuff;
-	char * fieldBuffer;
-	stringVec fields;
-	bool isDelim(const char) const;
+	spanVec fields;	//index into characters
 	void extractFields();
 
 	void setChars(const char *);	
 	void setChars(const char *, const int &);
-	bool parityCheck(const Bytef *, const int&, const int&) const;
-
-	//-------------------------Supported Character sets
-	//BCD	
-	int findSSBCD(void) const;
-	int findESBCD(const int&) const;
-	bool errorCheckBCD(const int&, const int&) const;
-	bool parseBCD();
-	void decodeBCD(const int&, const int&);
-	//ALPHA
-	int findSSAlpha(void) const;
-	int findESAlpha(const int&) const;
-	bool errorCheckAlpha(const int&, const int&) const;
-	bool parseAlpha();
-	void decodeAlpha(const int&, const int&);
-
-
-	void extractFields2();
-	bool isDelim(const char, const char *) const;
+
+	//-------------------------Decoding
+	int status;	//DECODE_* of the best attempt
+	int errorPos;	//bit that attempt stopped at
+	void evaluate(DecodeCandidate &) const;
+
+	//-------------------------Correction
+	bool correcting;	//try to repair a flipped bit or a bit slip
+	int corrections;	//repairs made
+	int correctedBit;	//bit of the bitstream that was flipped, or -1
+	int slip;		//SLIP_* repaired
+	int slipBit;		//bit of the original bitstream it was at, or -1
+	int correct(DecodeCandidate &) const;
+	int resync(DecodeCandidate &, Bitstream &, int &) const;
+	bool repair(DecodeCandidate &, char *);
+
+	//-------------------------Soft decision
+	bool soft;	//try the least confident bits first
+	std::shared_ptr<const Bytef> margins;	//timing margin of each bit
+	int numSoftBits;	//bits soft decision flipped
+	int softBits[SOFTFLIPS];	//and where, in the bitstream
+	int softCorrect(DecodeCandidate &, int *) const;
+	bool softRepair(DecodeCandidate &);
+
+	//-------------------------Timing
+	std::shared_ptr<const EdgeTimes> edgeTimes;	//when each bit's edge came
+
+	//-------------------------Forcing
+	std::shared_ptr<const char> forced;	//best effort characters, if forced
+	std::shared_ptr<const char> confidence;	//CONF_* for each of them
+	int forcedFormat;	//FORMAT_* they were read as
+	bool forcedReversed;
+	int forcedStatus;	//DECODE_* of the forced read
+	int force(const DecodeCandidate &, char *, char *, int &) const;
+	void forceBest(DecodeCandidate *, const int&, const int&);
+
+	//-------------------------Records
+	recordVec records;	//every record on the track, in bitstream order
+	std::shared_ptr<const char> recordBuffer;	//holds their characters
+	void findRecords(const int *, const int&);
 	
 };
 
@@ -0,0 +1,230 @@
+/**
+ * @file trackformat.cpp
+ * @brief Table of the track formats Stripe Snoop can decode.
+ *
+ * The built in formats are built from the descriptors in trackformat.h,
+ * which also instantiates the scanner for each of them. Custom formats
+ * from the config file are added after them at run time.
+ *
+ * @author Acidus (acidus@msblabs.org)
+ *
+ * This file is part of Stripe Snoop (http://stripesnoop.sourceforge.net)
+ *
+ * Stripe Snoop is licensed under the GPL. See COPYING for more info
+ *
+ * Copyright (C) 2005 Acidus, Most Significant Bit Labs
+ */
+
+#include "trackformat.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#define FORMAT(name, F) { name, F::charSet(), F::bits(), F::parityBits(), \
+			  F::maxChars(), { F::delimsLo(), F::delimsHi() }, \
+			  F::ss(), F::es(), F::table(), \
+			  &scanFormat<F>, &scanFormatRecord<F>, NULL }
+
+/** all known formats, by FORMAT_*, then custom formats */
+static FormatEntry formats[MAXFORMATS] = {
+	{ "None", NONE, 0, 0, 0, { 0, 0 }, 0, 0, NULL, NULL, NULL, NULL },
+	FORMAT("Track 1 Alpha", ISOTrack1),
+	FORMAT("Track 2 BCD", ISOTrack2),
+	FORMAT("Track 3 BCD", ISOTrack3),
+};
+
+static int numFormats = NUMFORMATS;
+
+const FormatEntry & formatEntry(const int &f) {
+	return formats[f];
+}
+
+int getNumFormats() {
+	return numFormats;
+}
+
+/**
+ * @param track track number, 1-3
+ * @return the FORMAT_* ISO uses for that track
+ */
+int isoFormat(const int &track) {
+	switch(track) {
+		case 1:
+			return FORMAT_TRACK1;
+		case 3:
+			return FORMAT_TRACK3;
+	}
+	return FORMAT_TRACK2;
+}
+
+/**
+ * scanner entry points for custom formats
+ */
+static int scanCustom(const FormatEntry &e, const BitView &bits, char * out,
+		      int &pos) {
+	return scanWith(*e.custom, bits, out, pos);
+}
+
+static int scanCustomRecord(const FormatEntry &e, const BitView &bits,
+			    const int &start, char * out, int &pos) {
+	return scanRecordWith(*e.custom, bits, start, out, pos);
+}
+
+/**
+ * adds a built custom format to the table. The table keeps the pointer
+ *
+ * @param c format, build() must have succeeded
+ * @return its FORMAT number, or -1 if the table is full
+ */
+int addFormat(const CustomFormat *c) {
+	if(numFormats == MAXFORMATS) {
+		printf("Too many character sets, ignoring \"%s\"\n", c->getName());
+		return -1;
+	}
+	FormatEntry &e = formats[numFormats];
+	e.name = c->getName();
+	e.charSet = c->charSet();
+	e.bits = c->bits();
+	e.parityBits = c->parityBits();
+	e.maxChars = c->maxChars();
+	e.delims[0] = c->delimsLo();
+	e.delims[1] = c->delimsHi();
+	e.ss = c->ss();
+	e.es = c->es();
+	e.table = c->table();
+	e.scan = &scanCustom;
+	e.scanRecord = &scanCustomRecord;
+	e.custom = c;
+	return numFormats++;
+}
+
+//-------------------------------------------------------------- CustomFormat
+
+CustomFormat::CustomFormat() {
+	name = NULL;
+	numBits = 0;
+	order = LSBFIRST;
+	parity = ODD;
+	map = NULL;
+	start = end = -1;
+	delims = NULL;
+	codes = NULL;
+	ssCode = esCode = 0;
+	setName("Custom");
+	setDelims("");
+}
+
+static char * copyString(const char *s) {
+	char * t = new char[strlen(s) + 1];
+	strcpy(t, s);
+	return t;
+}
+
+void CustomFormat::setName(const char *s) {
+	if(name != NULL)
+		delete [] name;
+	name = copyString(s);
+}
+
+const char * CustomFormat::getName() const {
+	return name;
+}
+
+void CustomFormat::setBits(const int &b) {
+	numBits = b;
+}
+
+void CustomFormat::setOrder(const int &o) {
+	order = o;
+}
+
+void CustomFormat::setParity(const int &p) {
+	parity = p;
+}
+
+void CustomFormat::setMap(const char *s) {
+	if(map != NULL)
+		delete [] map;
+	map = copyString(s);
+}
+
+void CustomFormat::setStart(const int &v) {
+	start = v;
+}
+
+void CustomFormat::setEnd(const int &v) {
+	end = v;
+}
+
+void CustomFormat::setDelims(const char *s) {
+	if(delims != NULL)
+		delete [] delims;
+	delims = copyString(s);
+}
+
+/**
+ * turns a data value into the raw code word recorded on the stripe, first
+ * bit in the most significant position and the parity bit last
+ */
+Wordf CustomFormat::encode(const int &v) const {
+	int dataBits = numBits - parityBits();
+	Wordf raw = 0;
+	int ones = 0;
+	for(int i = 0; i < dataBits; i++) {
+		int b = (order == LSBFIRST) ? (v >> i) & 1 : (v >> (dataBits - 1 - i)) & 1;
+		raw = (raw << 1) | b;
+		ones += b;
+	}
+	if(parity == ODD)
+		raw = (raw << 1) | ((ones % 2) == 0);
+	else if(parity == EVEN)
+		raw = (raw << 1) | ((ones % 2) == 1);
+	return raw;
+}
+
+/**
+ * checks the settings and generates the lookup table
+ * @return false if the format can't be used
+ */
+bool CustomFormat::build() {
+	int dataBits = numBits - parityBits();
+	if(numBits < 2 || numBits > 8 || dataBits < 1) {
+		printf("Character set \"%s\": bits must be 2-8\n", name);
+		return false;
+	}
+	if(map == NULL || start < 0 || end < 0 ||
+	   start >= (1 << dataBits) || end >= (1 << dataBits)) {
+		printf("Character set \"%s\": needs a map, start and end\n", name);
+		return false;
+	}
+	int n = 1 << numBits;
+	int len = strlen(map);
+	if(codes != NULL)
+		delete [] codes;
+	codes = new CharCode[n];
+	for(int r = 0; r < n; r++) {
+		//undo the bit order to get the data value back
+		int raw = r >> parityBits();
+		int v = 0;
+		int ones = 0;
+		for(int i = 0; i < dataBits; i++) {
+			int b = (raw >> (dataBits - 1 - i)) & 1;
+			if(order == LSBFIRST)
+				v |= b << i;
+			else
+				v = (v << 1) | b;
+		}
+		for(int i = 0; i < numBits; i++)
+			ones += (r >> i) & 1;
+		codes[r].ch = (v < len) ? map[v] : 'X'; //undefined character
+		if(parity == ODD)
+			codes[r].parity = (ones % 2) == 1;
+		else if(parity == EVEN)
+			codes[r].parity = (ones % 2) == 0;
+		else
+			codes[r].parity = true;
+	}
+	ssCode = encode(start);
+	esCode = encode(end);
+	return true;
+}
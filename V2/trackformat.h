@@ -0,0 +1,322 @@
+/*
+ * Track formats
+ *
+ * A format describes how characters are recorded on a track: bits per
+ * character, sentinels, the lookup table (which also knows parity) and the
+ * field delimiters. The scanner is a template over the format, so every
+ * format gets its own inner loop. For the built in formats everything is
+ * a compile time constant and gets folded in; formats defined in the
+ * config file use the same loop with their values read from a CustomFormat.
+ *
+ * To support a new built in format, write a descriptor like the ones below,
+ * give it a FORMAT_* number and add it to the formats[] table in
+ * trackformat.cpp
+ */
+
+#ifndef TRACKFORMAT_H
+#define TRACKFORMAT_H
+
+#include "bitstream.h"
+#include "charset.h"
+
+//-----------------------Defines
+//used for character sets
+#define NONE 0
+#define ALPHANUMERIC 1
+#define NUMERIC 2
+#define CUSTOM 3
+//parity defines
+#define ODD 1
+#define EVEN 0
+#define NOPARITY 2
+//bit order defines, which data bit is recorded first
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+#define ALPHADELIMS "%^?"
+#define NUMERICDELIMS ":<>=?"
+
+//decode status, why a track did or did not decode
+#define DECODE_OK 0
+#define DECODE_NOSS 1	//no start sentinel at the first 1 bit
+#define DECODE_NOES 2	//ran out of bits before an end sentinel
+#define DECODE_PARITY 3	//a character failed parity
+#define DECODE_NOLRC 4	//no room for the LRC after the end sentinel
+#define DECODE_LRC 5	//LRC didn't match
+
+//built in formats, custom formats are numbered after these
+#define FORMAT_NONE 0
+#define FORMAT_TRACK1 1	//ISO 7811 Track 1, 7 bit Alpha
+#define FORMAT_TRACK2 2	//ISO 7811 Track 2, 5 bit BCD
+#define FORMAT_TRACK3 3	//ISO 4909 Track 3, 5 bit BCD
+#define NUMFORMATS 4
+#define MAXFORMATS 16	//built in plus custom
+
+/**
+ * builds half of a 128 bit character bitmap from a string at compile time
+ * @param s characters to set
+ * @param half 0 for characters 0-63, 1 for 64-127
+ */
+constexpr Wordf charBitmap(const char * s, int half) {
+	return (*s == '\0') ? 0 :
+		((((*s >> 6) & 1) == half ? (Wordf) 1 << (*s & 63) : 0) |
+		 charBitmap(s + 1, half));
+}
+
+//----------------------------------------------------- Format descriptors
+
+class ISOTrack1 {
+public:
+	static constexpr int bits() { return ALPHABITS; }
+	static constexpr int parityBits() { return 1; }
+	static constexpr Wordf ss() { return 0x51; }	//'%' 1010001
+	static constexpr Wordf es() { return 0x7C; }	//'?' 1111100
+	static constexpr int maxChars() { return 79; }
+	static constexpr int charSet() { return ALPHANUMERIC; }
+	static constexpr const CharCode * table() { return AlphaTable; }
+	static constexpr Wordf delimsLo() { return charBitmap(ALPHADELIMS, 0); }
+	static constexpr Wordf delimsHi() { return charBitmap(ALPHADELIMS, 1); }
+};
+
+class ISOTrack2 {
+public:
+	static constexpr int bits() { return BCDBITS; }
+	static constexpr int parityBits() { return 1; }
+	static constexpr Wordf ss() { return 0x1A; }	//';' 11010
+	static constexpr Wordf es() { return 0x1F; }	//'?' 11111
+	static constexpr int maxChars() { return 40; }
+	static constexpr int charSet() { return NUMERIC; }
+	static constexpr const CharCode * table() { return BCDTable; }
+	static constexpr Wordf delimsLo() { return charBitmap(NUMERICDELIMS, 0); }
+	static constexpr Wordf delimsHi() { return charBitmap(NUMERICDELIMS, 1); }
+};
+
+//Track 3 is recorded just like Track 2, only denser and longer
+class ISOTrack3 : public ISOTrack2 {
+public:
+	static constexpr int maxChars() { return 107; }
+};
+
+/*
+ * CustomFormat - a format defined at run time, for proprietary stripes
+ *
+ * Set it up, then call build() to generate its lookup table. It has the
+ * same interface as the descriptors above, so it decodes through the same
+ * scanner.
+ */
+class CustomFormat {
+public:
+	CustomFormat();
+	void setName(const char *);
+	void setBits(const int&);
+	void setOrder(const int&);
+	void setParity(const int&);
+	void setMap(const char *);
+	void setStart(const int&);
+	void setEnd(const int&);
+	void setDelims(const char *);
+	bool build(void);
+
+	const char * getName(void) const;
+	int bits(void) const { return numBits; }
+	int parityBits(void) const { return (parity == NOPARITY) ? 0 : 1; }
+	Wordf ss(void) const { return ssCode; }
+	Wordf es(void) const { return esCode; }
+	int maxChars(void) const { return 0; }	//not known
+	int charSet(void) const { return CUSTOM; }
+	const CharCode * table(void) const { return codes; }
+	Wordf delimsLo(void) const { return charBitmap(delims, 0); }
+	Wordf delimsHi(void) const { return charBitmap(delims, 1); }
+
+private:
+	char * name;
+	int numBits;	//per character, including parity
+	int order;	//LSBFIRST or MSBFIRST
+	int parity;	//ODD, EVEN or NOPARITY
+	char * map;	//character for each data value
+	int start;	//data value of the start sentinel
+	int end;	//data value of the end sentinel
+	char * delims;
+
+	CharCode * codes;	//built lookup table
+	Wordf ssCode;
+	Wordf esCode;
+
+	Wordf encode(const int&) const;
+};
+
+//----------------------------------------------------- Scanner
+
+/**
+ * decodes a track of format F in a single pass.
+ *
+ * The start sentinel must be at the first 1 bit. From there each code
+ * word is looked up once: the table gives the character and its parity,
+ * the data bits go into the running LRC, and the character is written
+ * out. The loop body has no branches, a bad parity is only remembered,
+ * and the loop stops at the end sentinel. The next code word must be the
+ * LRC.
+ *
+ * @param f format descriptor
+ * @param bits view of the bitstream to decode, in either direction
+ * @param out buffer of at least getSize() / f.bits() + 1 chars
+ * @param pos set to the bit the decode stopped at
+ * @return DECODE_* status
+ */
+template <class F>
+int scanWith(const F &f, const BitView &bits, char * out, int &pos) {
+	const CharCode * table = f.table();
+	const int bpc = f.bits();
+	const int pb = f.parityBits();
+	const Wordf es = f.es();
+	int size = bits.getSize();
+	Wordf lrc = 0;
+	Wordf code;
+	int len = 0;
+	int bad = -1;	//first character to fail parity
+
+	out[0] = '\0';
+	pos = bits.firstSet(0);
+	if(pos < 0 || pos + bpc > size || bits.getBits(pos, bpc) != f.ss()) {
+		if(pos < 0)
+			pos = size;
+		return DECODE_NOSS;
+	}
+	int start = pos;
+	do {
+		code = bits.getBits(pos, bpc);
+		//Just XOR the Data Bits of each character, not the parity bit
+		lrc ^= code >> pb;
+		out[len++] = table[code].ch;
+		bad = (bad < 0 && !table[code].parity) ? pos : bad;
+		pos += bpc;
+	} while(code != es && pos + bpc <= size);
+	out[len] = '\0';
+
+	if(bad >= 0) {
+		out[(bad - start) / bpc] = '\0';
+		pos = bad;
+		return DECODE_PARITY;
+	}
+	if(code != es)
+		return DECODE_NOES;
+	if(pos + bpc > size)
+		return DECODE_NOLRC;
+	//LRC gets the same parity, so borrow the table to work it out
+	Wordf expect = lrc;
+	if(pb != 0)
+		expect = (lrc << 1) | (table[lrc << 1].parity ? 0 : 1);
+	if(bits.getBits(pos, bpc) != expect)
+		return DECODE_LRC;
+	return DECODE_OK;
+}
+
+/**
+ * decodes one record of format F whose start sentinel is at a given bit.
+ *
+ * Used to pick every record out of a track, so unlike scanWith() it stops
+ * as soon as it knows there isn't a record here: at a character that fails
+ * parity, or at another start sentinel, which is where the next attempt
+ * will start. That way attempts that start in the same alignment never
+ * read the same bits twice.
+ *
+ * @param f format descriptor
+ * @param bits view of the bitstream to decode, in either direction
+ * @param start bit the start sentinel begins at
+ * @param out buffer of at least getSize() / f.bits() + 1 chars
+ * @param pos set to the bit after the LRC if the end sentinel was found,
+ *	otherwise to the bit the scan stopped at
+ * @return DECODE_OK, DECODE_LRC or DECODE_NOLRC for a record, DECODE_PARITY
+ *	or DECODE_NOES if there isn't one
+ */
+template <class F>
+int scanRecordWith(const F &f, const BitView &bits, const int &start,
+		   char * out, int &pos) {
+	const CharCode * table = f.table();
+	const int bpc = f.bits();
+	const int pb = f.parityBits();
+	const Wordf ss = f.ss();
+	const Wordf es = f.es();
+	int size = bits.getSize();
+	Wordf lrc = ss >> pb;
+	Wordf code;
+	int len = 0;
+
+	out[len++] = table[ss].ch;
+	pos = start + bpc;
+	do {
+		if(pos + bpc > size) {
+			out[len] = '\0';
+			return DECODE_NOES;
+		}
+		code = bits.getBits(pos, bpc);
+		if(!table[code].parity || code == ss) {
+			out[len] = '\0';
+			return (code == ss) ? DECODE_NOES : DECODE_PARITY;
+		}
+		lrc ^= code >> pb;
+		out[len++] = table[code].ch;
+		pos += bpc;
+	} while(code != es);
+	out[len] = '\0';
+
+	if(pos + bpc > size) {
+		pos = size;
+		return DECODE_NOLRC;
+	}
+	Wordf expect = lrc;
+	if(pb != 0)
+		expect = (lrc << 1) | (table[lrc << 1].parity ? 0 : 1);
+	code = bits.getBits(pos, bpc);
+	pos += bpc;
+	return (code == expect) ? DECODE_OK : DECODE_LRC;
+}
+
+//----------------------------------------------------- Format table
+
+//what the rest of the code needs to know about a format at run time
+class FormatEntry {
+public:
+	const char * name;
+	int charSet;
+	int bits;
+	int parityBits;	//1, or 0 with no parity
+	int maxChars;	//longest a track can be, sentinels and LRC included
+	Wordf delims[2];	//bitmap of the delimiter characters
+	Wordf ss;	//code word of the start sentinel
+	Wordf es;	//code word of the end sentinel
+	const CharCode * table;	//lookup by code word
+	int (*scan)(const FormatEntry &, const BitView &, char *, int &);
+	int (*scanRecord)(const FormatEntry &, const BitView &, const int &,
+			  char *, int &);
+	const CustomFormat * custom;	//NULL for built in formats
+};
+
+/**
+ * scanner entry points for built in format F
+ */
+template <class F>
+int scanFormat(const FormatEntry &, const BitView &bits, char * out, int &pos) {
+	return scanWith(F(), bits, out, pos);
+}
+
+template <class F>
+int scanFormatRecord(const FormatEntry &, const BitView &bits,
+		     const int &start, char * out, int &pos) {
+	return scanRecordWith(F(), bits, start, out, pos);
+}
+
+const FormatEntry & formatEntry(const int&);
+int getNumFormats(void);
+int isoFormat(const int&);
+int addFormat(const CustomFormat *);
+
+/**
+ * @return true if ch is a field delimiter in format f
+ */
+inline bool isFormatDelim(const int &f, const char &ch) {
+	unsigned char c = (unsigned char) ch;
+	return (c < 128) && ((formatEntry(f).delims[c >> 6] >> (c & 63)) & 1);
+}
+
+#endif